@@ -0,0 +1,55 @@
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "App.hpp"
+
+// Renders a stress scene offscreen along a scripted camera path, vsync off, and writes frame time statistics:
+// ICPBenchmark [--scene bunnies|trees] [--count N] [--frames N] [--warmup N] [--size WIDTHxHEIGHT]
+//              [--no-occlusion] [--output PATH]
+// or measures OBJ load time against triangle count, without a window:
+// ICPBenchmark --scene loader [--sizes N] [--output PATH]
+int main(int argc, char* argv[])
+{
+    try {
+        HeadlessSettings headless;
+        headless.enabled = true;
+        BenchmarkSettings benchmark;
+        for (int i = 1; i < argc; i++) {
+            std::string_view arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if (arg == "--scene" && has_value)
+                benchmark.scene = argv[++i];
+            else if (arg == "--count" && has_value)
+                benchmark.count = static_cast<unsigned int>(std::stoul(argv[++i]));
+            else if (arg == "--frames" && has_value)
+                benchmark.frames = std::stoull(argv[++i]);
+            else if (arg == "--warmup" && has_value)
+                benchmark.warmup_frames = std::stoull(argv[++i]);
+            else if (arg == "--size" && has_value && std::sscanf(argv[i + 1], "%dx%d", &headless.width, &headless.height) == 2)
+                i++;
+            else if (arg == "--sizes" && has_value)
+                benchmark.loader_sizes = static_cast<unsigned int>(std::stoul(argv[++i]));
+            else if (arg == "--no-occlusion")
+                benchmark.occlusion_culling = false;
+            else if (arg == "--output" && has_value)
+                benchmark.output = argv[++i];
+            else
+                throw std::runtime_error("Invalid argument: " + std::string(arg));
+        }
+
+        if (benchmark.scene == "loader")
+            return benchmarkLoader(benchmark) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+        // only a rendering run creates the window and GL context, the loader needs neither
+        App app;
+        if (app.init(headless, benchmark))
+            return app.run();
+    }
+    catch (std::exception const& e) {
+        std::cerr << "Benchmark failed : " << e.what() << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    return EXIT_SUCCESS;
+}
@@ -1,5 +1,7 @@
-﻿#include <iostream>
+﻿#include <cstdio>
+#include <iostream>
 #include <numeric>
+#include <string_view>
 
 #include <glm/glm.hpp>
 #define GLM_ENABLE_EXPERIMENTAL
@@ -99,12 +101,26 @@ int hsv_finder(const char *filepath)
     return(EXIT_SUCCESS); //TODO: getting a segmentation fault on exit
 }
 
-int main()
+int main(int argc, char* argv[])
 {
     //Commented out code is stored for later as a reference or for moving to classes or local libraries
     
     try {
-        if (app.init())
+        // --headless [--size WIDTHxHEIGHT] [--frames N]: offscreen rendering without window and camera
+        HeadlessSettings headless;
+        for (int i = 1; i < argc; i++) {
+            std::string_view arg = argv[i];
+            if (arg == "--headless")
+                headless.enabled = true;
+            else if (arg == "--size" && i + 1 < argc && std::sscanf(argv[i + 1], "%dx%d", &headless.width, &headless.height) == 2)
+                i++;
+            else if (arg == "--frames" && i + 1 < argc)
+                headless.frames = std::stoull(argv[++i]);
+            else
+                throw std::runtime_error("Invalid argument: " + std::string(arg));
+        }
+
+        if (app.init(headless))
             return app.run();
     }
     catch (std::exception const& e) {
@@ -1,8 +1,9 @@
 #pragma once
 
 #include <opencv2/opencv.hpp>
+#include <optional>
 #include <vector>
-#include <gl/glew.h>
+#include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
@@ -13,15 +14,35 @@
 #include "Assets.hpp"
 #include "ShaderProgram.hpp"
 #include "Mesh.hpp"
-#include "Model.hpp"
+#include "Scene.hpp"
+#include "InstancedModel.hpp"
 #include "Camera.hpp"
+#include "JobSystem.hpp"
+#include "AssetStreamer.hpp"
+#include "GeometryArena.hpp"
+#include "RenderQueue.hpp"
+#include "FrustumCuller.hpp"
+#include "HiZBuffer.hpp"
+#include "GpuProfiler.hpp"
+#include "FrameUniforms.hpp"
+#include "RenderStats.hpp"
+#include "Benchmark.hpp"
+
+// offscreen rendering into a framebuffer object, for CI and batch render nodes
+struct HeadlessSettings {
+    bool enabled{ false };
+    int width{ HEADLESS_WIDTH };
+    int height{ HEADLESS_HEIGHT };
+    uint64_t frames{ HEADLESS_FRAMES }; // rendered by run(), 0 = until terminated
+};
 
 class App {
 public:
     App();
 
 
-    bool init(void);
+    // with benchmark_settings, a stress scene is rendered along a scripted path and statistics are written at the end
+    bool init(const HeadlessSettings& headless_settings = {}, const std::optional<BenchmarkSettings>& benchmark_settings = std::nullopt);
     void destroy(void);
 
     int run(void);
@@ -37,7 +58,17 @@ private:
     void init_glfw();
     void init_opencv();
     void init_assets();
+    void load_model(const std::string& name, const std::filesystem::path& filename, std::shared_ptr<ShaderProgram> shader);
+    void load_instanced_model(const std::string& name, const std::filesystem::path& filename, std::shared_ptr<ShaderProgram> shader);
+    // returns center of the forest
+    glm::vec3 plant_forest(const std::string& name, int count);
+    void init_benchmark_scene();
     void init_imgui();
+    void init_offscreen();
+    void save_screenshot(void);
+
+    // one camera frame of the face tracker, resubmits itself
+    void tracker_job();
 
     void check_gl_version();
 
@@ -61,8 +92,18 @@ private:
     void update_projection_matrix(void);
 
     GLFWwindow* window = nullptr;
+    HeadlessSettings headless;
+    GLuint offscreen_framebuffer{ 0 }; // render target in headless mode, 0 = window
+    GLuint offscreen_color{ 0 };
+    GLuint offscreen_depth{ 0 };
+    std::optional<BenchmarkSettings> benchmark;
+    BenchmarkPath benchmark_path;
+    BenchmarkRecorder benchmark_recorder;
     bool is_vsync_on{ true };
     bool show_imgui{ true };
+    bool show_lod_debug{ false };
+    bool occlusion_culling{ OCCLUSION_CULLING };
+    RenderStats render_stats;
     float game_speed{ 1.0 };
     bool paused_by_key{ false };
 
@@ -82,11 +123,16 @@ private:
     cv::VideoCapture capture;
     cv::Mat image_intruder;
     cv::Mat image_no_face;
+    // worker threads shared by loading, tracking and scene update, declared before (destroyed after) its users
+    JobSystem job_system;
+    std::vector<JobSystem::WorkerStats> job_stats; // sampled every JOB_STATS_INTERVAL
+
     std::atomic<bool> tracker_terminate; //if true terminate the tracker loop
     std::atomic<bool> tracker_buffer_empty;
+    std::atomic<bool> tracker_done{ true }; // no tracker job queued or running
     std::vector<cv::Point2f> tracker_result;
     std::mutex points_result_mutex;
-    std::thread tracker_thread;
+    cv::CascadeClassifier face_cascade;
 
     //this is just for image display in the main thread
     //pos deque to make the crosshair synchronized with the image
@@ -100,7 +146,20 @@ private:
     std::unordered_map<std::string, std::shared_ptr<Mesh>> mesh_library;
 
     // all objects on the scene
-    std::unordered_map<std::string, Model> scene;
+    Scene scene;
+
+    // objects repeated many times, drawn by instancing
+    std::unordered_map<std::string, InstancedModel> instanced_scene;
+
+    // background loading of models
+    AssetStreamer asset_streamer{ job_system };
+
+    // all meshes share its buffers, the scene is drawn by multi-draw indirect in sorted order
+    std::shared_ptr<GeometryArena> geometry_arena;
+    RenderQueue render_queue;
+    FrustumCuller frustum_culler;
+    std::unique_ptr<HiZBuffer> hiz_buffer; // depth of previous frames for occlusion culling
+    GpuProfiler gpu_profiler;
 
     int viewport_width, viewport_height;
     float FOV_degrees = 60.0f;
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Config.hpp"
+#include "GeometryArena.hpp"
+#include "JobSystem.hpp"
+#include "Mesh.hpp"
+#include "MeshCache.hpp"
+#include "NonCopyable.hpp"
+#include "SyncedDequePartialImpl.hpp"
+
+// Asynchronous model loading. Files are parsed (or read from mesh cache) by jobs,
+// GPU upload is done on the GL thread by update(), limited by per-frame budget.
+class AssetStreamer : private NonCopyable
+{
+public:
+    struct StreamedMesh {
+        std::string name; // submesh name
+        std::shared_ptr<Mesh> mesh;
+    };
+    // called on the GL thread, when all submeshes of the model are on GPU
+    using ReadyCallback = std::function<void(std::vector<StreamedMesh>& meshes)>;
+
+    explicit AssetStreamer(JobSystem& jobs);
+    // waits for running parse jobs
+    ~AssetStreamer();
+
+    void request(const std::filesystem::path& filename, ReadyCallback on_ready);
+
+    // meshes created from now on are sub-allocated in the arena (own buffers without it)
+    void setGeometryArena(std::shared_ptr<GeometryArena> arena) { arena_ = std::move(arena); }
+
+    // Upload parsed meshes, stop when any budget is exhausted. Call once per frame from the GL thread.
+    void update(size_t budget_bytes = ASSET_UPLOAD_BUDGET_BYTES, double budget_ms = ASSET_UPLOAD_BUDGET_MS);
+
+    // Block until all requested models are loaded and uploaded (no budget).
+    void finish(void);
+
+    // number of requested models not yet ready
+    size_t pending(void) const { return pending_; }
+
+private:
+    struct Request {
+        std::filesystem::path filename;
+        ReadyCallback on_ready;
+    };
+
+    struct Parsed {
+        Request request;
+        CachedMesh data;
+        bool ok{ false };
+    };
+
+    struct Upload {
+        std::shared_ptr<Parsed> parsed;
+        std::vector<StreamedMesh> meshes;
+        size_t submesh{ 0 };        // submesh being uploaded
+        size_t vertices_done{ 0 };
+        size_t indices_done{ 0 };
+    };
+
+    void parse(Request request);
+
+    // background side
+    JobSystem& jobs_;
+    synced_deque<std::shared_ptr<Parsed>> parsed_;
+
+    // GL thread side
+    std::vector<JobSystem::JobHandle> parse_jobs_; // not finished yet
+    std::deque<Upload> uploads_;
+    std::shared_ptr<GeometryArena> arena_;
+    std::atomic<size_t> pending_{ 0 };
+};
@@ -1,6 +1,14 @@
 #pragma once
 
-#include <glm/glm.hpp> 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
 
 struct Vertex {
     glm::vec3 position;
@@ -12,4 +20,87 @@ struct Vertex {
             && normal == v1.normal
             && texCoords == v1.texCoords);
     }
-};
\ No newline at end of file
+};
+
+// GPU vertex, half the size of Vertex (see Mesh::VertexFormat::compact)
+struct CompactVertex {
+    uint16_t position[4]; // unsigned normalized, relative to mesh bounds, [3] unused
+    uint32_t normal;      // signed normalized, GL_INT_2_10_10_10_REV
+    uint32_t texCoords;   // 2x half float
+};
+static_assert(sizeof(CompactVertex) == sizeof(Vertex) / 2);
+
+// axis aligned bounding box, empty by default
+struct AABB {
+    glm::vec3 min_point{ std::numeric_limits<float>::max() };
+    glm::vec3 max_point{ std::numeric_limits<float>::lowest() };
+
+    bool empty() const { return min_point.x > max_point.x; }
+    glm::vec3 center() const { return (min_point + max_point) * 0.5f; }
+    glm::vec3 extents() const { return (max_point - min_point) * 0.5f; }
+
+    void extend(const glm::vec3& point) {
+        min_point = glm::min(min_point, point);
+        max_point = glm::max(max_point, point);
+    }
+
+    static AABB of(std::span<const Vertex> vertices) {
+        AABB bounds;
+        for (const auto& vertex : vertices)
+            bounds.extend(vertex.position);
+        return bounds;
+    }
+};
+
+// sphere around the box center, with radius to the farthest vertex (usually tighter than the box diagonal)
+struct BoundingSphere {
+    glm::vec3 center{ 0.0f };
+    float radius{ -1.0f };
+
+    bool empty() const { return radius < 0.0f; }
+
+    static BoundingSphere of(std::span<const Vertex> vertices, const AABB& bounds) {
+        if (bounds.empty())
+            return BoundingSphere{};
+        BoundingSphere sphere{ bounds.center(), 0.0f };
+        float radius2 = 0.0f;
+        for (const auto& vertex : vertices) {
+            glm::vec3 d = vertex.position - sphere.center;
+            radius2 = std::max(radius2, glm::dot(d, d));
+        }
+        sphere.radius = std::sqrt(radius2);
+        return sphere;
+    }
+
+    static BoundingSphere of(const AABB& bounds) {
+        return bounds.empty() ? BoundingSphere{} : BoundingSphere{ bounds.center(), glm::length(bounds.extents()) };
+    }
+};
+
+// range of submesh indices with one level of detail, all levels share vertices
+struct MeshLod {
+    uint32_t first_index;
+    uint32_t index_count;
+    float error; // simplification error relative to mesh size
+};
+
+// cluster of neighbouring triangles, contiguous range of indices
+struct Meshlet {
+    uint32_t first_index;
+    uint32_t index_count;
+    glm::vec3 center;    // bounding sphere
+    float radius;
+    glm::vec3 cone_axis; // normal cone, the cluster faces away from the camera at position "eye" if
+    float cone_cutoff;   // dot(center - eye, cone_axis) >= cone_cutoff * length(center - eye) + radius
+};
+
+// independent part of loaded model (e.g. one OBJ object/group/material), indices are local to the part
+struct SubmeshData {
+    std::string name;
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    AABB bounds;
+    BoundingSphere sphere;
+    std::vector<MeshLod> lods; // empty = single level made of all indices
+    std::vector<Meshlet> meshlets; // clusters of LOD 0, empty = mesh is drawn whole
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <nlohmann/json.hpp>
+
+#include "Config.hpp"
+#include "RenderStats.hpp"
+
+// stress scene and length of a benchmark run
+struct BenchmarkSettings {
+    std::string scene{ BENCHMARK_SCENE };              // "bunnies" (separate meshes on a grid), "trees" (instanced forest) or "loader"
+    unsigned int count{ BENCHMARK_OBJECT_COUNT };      // bunnies or trees
+    uint64_t warmup_frames{ BENCHMARK_WARMUP_FRAMES }; // rendered, not measured
+    uint64_t frames{ BENCHMARK_FRAMES };               // measured
+    bool occlusion_culling{ OCCLUSION_CULLING };
+    unsigned int loader_sizes{ BENCHMARK_LOADER_SIZES }; // generated meshes of the "loader" scene
+    std::filesystem::path output{ BENCHMARK_OUTPUT };  // .json summary and .csv per frame
+};
+
+// Scripted camera flight, the same in every run: one circle around the center at height above it,
+// looking at the center, over the measured frames.
+struct BenchmarkPath {
+    glm::vec3 center{ 0.0f };
+    float radius{ 10.0f };
+    float height{ 2.0f };
+
+    // yaw and pitch in degrees, as Camera uses them
+    void pose(uint64_t frame, uint64_t frame_count, glm::vec3& position, float& yaw, float& pitch) const;
+};
+
+// "loader" scene: generates OBJ grids of increasing triangle count, loads each of them serially and in parallel
+// and writes load times against triangles to <output>.json and <output>.csv. Needs no window.
+bool benchmarkLoader(const BenchmarkSettings& settings);
+
+// Per frame samples of a benchmark run and their statistics (min/avg/p50/p95/p99/max).
+// Values are rounded to microseconds and written in fixed order, so that results of two builds can be diffed.
+class BenchmarkRecorder
+{
+public:
+    explicit BenchmarkRecorder(uint64_t warmup_frames = 0) : warmup_frames_{ warmup_frames } {}
+
+    // frames are numbered from 0 in order of addFrame(), GPU time of a frame is known a few frames later
+    void addFrame(double cpu_ms, const RenderStats& stats);
+    void setGpuTime(uint64_t frame, double gpu_ms);
+
+    // <output>.json with info and statistics of measured frames, <output>.csv with all measured frames
+    bool write(const std::filesystem::path& output, const nlohmann::ordered_json& info) const;
+
+private:
+    struct Frame {
+        double cpu_ms{ 0.0 };
+        double gpu_ms{ -1.0 }; // -1 = not measured
+        RenderStats stats;
+    };
+
+    template <typename Value>
+    nlohmann::ordered_json summarize(Value value) const;
+
+    uint64_t warmup_frames_;
+    std::vector<Frame> frames_;
+};
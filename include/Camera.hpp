@@ -105,6 +105,14 @@ public:
         this->updateCameraVectors();
     }
 
+    // absolute orientation, e.g. of a scripted flight
+    void SetOrientation(GLfloat yaw, GLfloat pitch)
+    {
+        this->Yaw = yaw;
+        this->Pitch = pitch;
+        this->updateCameraVectors();
+    }
+
     glm::mat4 GetViewMatrix() {
         return glm::lookAt(this->Position, this->Position + this->Front, this->Up);
     }
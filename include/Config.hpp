@@ -17,6 +17,89 @@
 #define NEAR_CLIP_PLANE 0.1f
 #define FAR_CLIP_PLANE 20000.0f
 
+//OBJ loader config
+#define OBJ_LOADER_PARALLEL true
+#define OBJ_LOADER_MIN_CHUNK_SIZE (1 << 20) // in bytes, each thread gets at least this much of the file
+
+//mesh optimizer config (applied when a model is loaded through the mesh cache)
+#define MESH_OPTIMIZE_VERTEX_CACHE true
+#define MESH_OPTIMIZE_OVERDRAW true
+#define MESH_OPTIMIZE_VERTEX_FETCH true
+#define MESH_OPTIMIZE_CACHE_SIZE 16 // simulated post-transform cache entries
+
+//mesh LOD config
+#define MESH_LOD_COUNT 4 // levels including the original mesh, 1 = no LODs
+#define MESH_LOD_REDUCTION 0.5f // triangle ratio of consecutive levels
+#define MESH_LOD_MAX_ERROR 0.05f // relative to mesh size
+#define MODEL_LOD_SCREEN_SIZE 0.25f // projected bounding sphere radius (fraction of viewport height) below which LOD 1 is used, each next LOD at half of it
+#define MODEL_LOD_HYSTERESIS 0.2f // in LOD levels, how far past the switching size the LOD changes
+
+//meshlet config
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+#define MESHLET_MIN_MESH_TRIANGLES 1024 // smaller meshes are not split, culled only as a whole
+#define MESHLET_CONE_CULLING false // skip clusters facing away from camera; only for closed meshes, back faces are drawn (no GL_CULL_FACE)
+
+//mesh GPU format config
+#define MESH_COMPACT_VERTICES true // 16 B vertices: positions quantized to bounds, packed normals, half float UVs
+#define MESH_SHORT_INDICES true // 16-bit indices for meshes with at most 65536 vertices
+#define GEOMETRY_ARENA_VERTICES (1 << 21) // capacity of the shared vertex buffer
+#define GEOMETRY_ARENA_INDICES (1 << 23) // capacity of each shared index buffer (16 and 32-bit)
+#define MULTIDRAW_DRAW_DATA_BINDING 0 // SSBO binding of per-draw data (model matrix, tint), indexed by gl_BaseInstance
+#define FRAME_UNIFORMS_BINDING 0 // uniform block of frame-global data shared by all shaders
+#define FRAME_UNIFORMS_BUFFERING 3 // copies of the block in flight
+#define FRAME_UNIFORMS_WAIT_NS 1'000'000'000 // max. wait for the GPU to release a copy, the frame keeps old data after it
+#define INSTANCE_DATA_BINDING 1 // SSBO binding of per-instance data of InstancedModel, indexed by gl_InstanceID
+
+//instancing demo config
+#define INSTANCED_FOREST false // stress test, instances are not culled (all of them are drawn every frame)
+#define INSTANCED_TREE_COUNT 100000
+#define INSTANCED_TREE_SPACING 2.0f // distance of grid cells
+#define INSTANCED_TREE_SCALE 0.05f
+
+//job system config
+#define JOB_SYSTEM_THREADS 0 // worker threads, 0 = hardware threads - 1
+#define JOB_GRAIN_SIZE 1024 // elements per parallelFor() chunk of light per-element work (culling)
+#define JOB_STATS_INTERVAL 1.0 // in seconds, worker utilization shown in the info window
+
+//occlusion culling config
+#define OCCLUSION_CULLING true // initial state, toggled in the GUI
+#define HIZ_READBACK_WIDTH 256 // max. width of the depth pyramid level read back to CPU
+#define HIZ_READBACK_BUFFERS 3 // readbacks in flight, the depth used for tests is up to this many frames old
+
+//headless config (--headless: offscreen rendering without window, camera and vsync)
+#define HEADLESS_WIDTH 1920
+#define HEADLESS_HEIGHT 1080
+#define HEADLESS_FRAMES 600 // rendered before exit, 0 = until terminated
+
+//benchmark config (ICPBenchmark executable, always headless)
+#define BENCHMARK_SCENE "bunnies" // "bunnies", "trees" or "loader" (OBJ load time, nothing rendered)
+#define BENCHMARK_OBJECT_COUNT 1000
+#define BENCHMARK_SPACING 10.0f // distance of bunnies on the grid
+#define BENCHMARK_WARMUP_FRAMES 60
+#define BENCHMARK_FRAMES 1000
+#define BENCHMARK_TIME_STEP (1.0 / 60.0) // in s, fixed for every frame, so that animation does not depend on speed
+#define BENCHMARK_OUTPUT "../benchmarks/result" // .json and .csv are appended
+#define BENCHMARK_LOADER_MIN_TRIANGLES 16384 // smallest generated mesh, doubled for every next size
+#define BENCHMARK_LOADER_SIZES 8
+#define BENCHMARK_LOADER_RUNS 5 // measured loads of each size, serial and parallel, after one unmeasured load
+
+//asset streaming config
+#define ASSET_UPLOAD_BUDGET_BYTES (4 << 20) // max. bytes uploaded to GPU per frame
+#define ASSET_UPLOAD_BUDGET_MS 2.0 // max. time spent by uploading per frame
+
+//shader config
+#define SHADER_CACHE_ENABLED true // keep linked program binaries, skip compilation when sources and driver did not change
+#define SHADER_CACHE_DIRECTORY "../cache/shaders"
+#define SHADER_COMPILER_THREADS 0xFFFFFFFF // for GL_KHR_parallel_shader_compile, 0xFFFFFFFF = driver decides
+#define SHADER_HOT_RELOAD true // recompile changed shader files while running, interactive runs only (not headless)
+#define SHADER_HOT_RELOAD_INTERVAL 0.5 // in s, how often the files are checked
+
+//GPU profiler config
+#define GPU_PROFILER_FRAMES 4 // frames in flight of timer queries, results are read this many frames later
+#define GPU_PROFILER_SMOOTHING 0.05 // weight of new value in moving average
+#define GPU_PROFILER_LOG_INTERVAL 10.0 // in s, 0 = no log
+
 //screenshot config
 #define SCREENSHOT_FILE_NAME "Screenshot"
 #define SCREENSHOT_TIMESTAMP_FORMAT "%F_%H-%M-%S"
\ No newline at end of file
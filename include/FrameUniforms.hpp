@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Config.hpp"
+#include "NonCopyable.hpp"
+
+// Frame-global shader data in one std140 uniform block shared by all shaders (FrameUniforms in GLSL,
+// binding FRAME_UNIFORMS_BINDING). The buffer is persistently mapped and has FRAME_UNIFORMS_BUFFERING
+// copies, so that the CPU writes one while the GPU still reads the others; fences guard the reuse.
+class FrameUniforms : private NonCopyable
+{
+public:
+    // std140 layout, must match the shaders
+    struct Data {
+        glm::mat4 view{ 1.0f };
+        glm::mat4 projection{ 1.0f };
+        glm::mat4 view_projection{ 1.0f };
+        glm::vec4 camera_position{ 0.0f }; // w unused
+        glm::vec4 color{ 1.0f };           // global tint
+        float time{ 0.0f };                // s
+        float delta_time{ 0.0f };
+        float padding[2]{};
+    };
+    // the block is repeated in basic.vert, basic.frag and instanced.vert
+    static_assert(offsetof(Data, view) == 0 && offsetof(Data, projection) == 64 && offsetof(Data, view_projection) == 128);
+    static_assert(offsetof(Data, camera_position) == 192 && offsetof(Data, color) == 208);
+    static_assert(offsetof(Data, time) == 224 && offsetof(Data, delta_time) == 228 && sizeof(Data) == 240);
+
+    FrameUniforms();
+    ~FrameUniforms();
+
+    // writes the next copy and binds it, call once per frame before drawing. If the GPU holds all copies
+    // longer than FRAME_UNIFORMS_WAIT_NS, the write is skipped and the previous data stay bound.
+    void update(const Data& data);
+
+    // call after all draws of the frame
+    void endFrame();
+
+    const Data& getData() const { return data_; }
+
+private:
+    // waits for the GPU to finish reading the copy, false on timeout
+    bool release(size_t index, GLuint64 timeout);
+
+    Data data_;
+    GLuint buffer_{ 0 };
+    char* mapped_{ nullptr };
+    GLsizeiptr stride_{ 0 };  // size of one copy, aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    size_t current_{ 0 };
+    std::array<GLsync, FRAME_UNIFORMS_BUFFERING> fences_{};
+};
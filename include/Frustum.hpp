@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <glm/glm.hpp>
+
+// View frustum planes extracted from a clip matrix (Gribb, Hartmann), in the space the matrix transforms from.
+// E.g. projection * view * model gives planes in model space.
+class Frustum
+{
+public:
+    Frustum() = default;
+
+    explicit Frustum(const glm::mat4& clip_matrix) {
+        auto row = [&](int i) { return glm::vec4(clip_matrix[0][i], clip_matrix[1][i], clip_matrix[2][i], clip_matrix[3][i]); };
+        planes_[0] = row(3) + row(0); // left
+        planes_[1] = row(3) - row(0); // right
+        planes_[2] = row(3) + row(1); // bottom
+        planes_[3] = row(3) - row(1); // top
+        planes_[4] = row(3) + row(2); // near
+        planes_[5] = row(3) - row(2); // far
+        for (auto& plane : planes_)
+            plane = plane / glm::length(glm::vec3(plane));
+    }
+
+    // conservative, may return true for spheres near frustum corners
+    bool intersectsSphere(const glm::vec3& center, float radius) const {
+        for (const auto& plane : planes_) {
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+                return false;
+        }
+        return true;
+    }
+
+    // normals point inside, (normal, distance)
+    const std::array<glm::vec4, 6>& getPlanes() const { return planes_; }
+
+private:
+    // normals point inside
+    std::array<glm::vec4, 6> planes_{};
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Frustum.hpp"
+#include "RenderStats.hpp"
+
+class JobSystem;
+class HiZBuffer;
+
+// Batched frustum test of world space bounding spheres. Spheres are collected into contiguous arrays
+// (structure of arrays) and tested four at a time with SSE, then the results are queried by index.
+class FrustumCuller
+{
+public:
+    void clear();
+
+    // returns index for isVisible()
+    uint32_t add(const glm::vec3& center, float radius);
+
+    // for filling from more threads: resize, then set() disjoint indices
+    void resize(size_t count);
+    void set(uint32_t index, const glm::vec3& center, float radius);
+
+    // tests all spheres, counts visible, culled and occluded meshes to stats; in parallel chunks with jobs,
+    // spheres inside the frustum are also tested against occlusion
+    void cull(const Frustum& frustum, RenderStats& stats, JobSystem* jobs = nullptr, const HiZBuffer* occlusion = nullptr);
+
+    bool isVisible(uint32_t index) const { return visible_[index] != 0; }
+    size_t size() const { return radius_.size(); }
+
+private:
+    // visible spheres of [begin, end), occluded ones are added to occluded
+    size_t cull_range(const Frustum& frustum, const HiZBuffer* occlusion, size_t begin, size_t end, size_t& occluded);
+
+    std::vector<float> center_x_;
+    std::vector<float> center_y_;
+    std::vector<float> center_z_;
+    std::vector<float> radius_;
+    std::vector<uint8_t> visible_;
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <GL/glew.h>
+
+#include "Config.hpp"
+#include "NonCopyable.hpp"
+#include "VertexLayout.hpp"
+
+// One immutable vertex buffer and index buffers (16 and 32-bit) shared by all meshes, with a vertex array
+// per index type. Meshes are sub-allocated, so that the whole scene can be drawn by a few multi-draw calls.
+class GeometryArena : private NonCopyable
+{
+public:
+    struct Allocation {
+        size_t first_vertex{ 0 };
+        size_t vertex_count{ 0 };
+        size_t first_index{ 0 };
+        size_t index_count{ 0 };
+        GLenum index_type{ GL_UNSIGNED_INT };
+    };
+
+    // capacities in vertices / indices (of each index type)
+    GeometryArena(size_t vertex_capacity = GEOMETRY_ARENA_VERTICES, size_t index_capacity = GEOMETRY_ARENA_INDICES,
+        VertexFormat format = default_vertex_format);
+    ~GeometryArena();
+
+    // empty if there is not enough space
+    std::optional<Allocation> allocate(size_t vertex_count, size_t index_count, GLenum index_type);
+    void release(const Allocation& allocation);
+
+    VertexFormat getVertexFormat() const { return format_; }
+    GLuint getVertexBuffer() const { return vbo_; }
+    GLuint getIndexBuffer(GLenum index_type) const { return index_type == GL_UNSIGNED_SHORT ? ebo16_ : ebo32_; }
+    GLuint getVertexArray(GLenum index_type) const { return index_type == GL_UNSIGNED_SHORT ? vao16_ : vao32_; }
+
+    // used / total bytes of all buffers
+    size_t usedBytes() const;
+    size_t capacityBytes() const;
+
+private:
+    // first fit, neighbouring free ranges are merged
+    class RangeAllocator {
+    public:
+        explicit RangeAllocator(size_t capacity) : capacity_{ capacity } { free_[0] = capacity; }
+        std::optional<size_t> allocate(size_t size);
+        void release(size_t offset, size_t size);
+        size_t used() const { return used_; }
+        size_t capacity() const { return capacity_; }
+    private:
+        std::map<size_t, size_t> free_; // offset -> size
+        size_t capacity_;
+        size_t used_{ 0 };
+    };
+
+    VertexFormat format_;
+    RangeAllocator vertices_;
+    RangeAllocator indices16_;
+    RangeAllocator indices32_;
+
+    GLuint vbo_{ 0 };
+    GLuint ebo16_{ 0 };
+    GLuint ebo32_{ 0 };
+    GLuint vao16_{ 0 };
+    GLuint vao32_{ 0 };
+};
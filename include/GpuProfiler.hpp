@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <GL/glew.h>
+
+#include "Config.hpp"
+#include "NonCopyable.hpp"
+
+// GPU time of named scopes, measured by GL_TIMESTAMP queries (they can be nested, unlike GL_TIME_ELAPSED).
+// Queries of the last GPU_PROFILER_FRAMES frames live in a ring, results are read only when available,
+// so reading never waits for the GPU; frames whose results are late are dropped.
+class GpuProfiler : private NonCopyable
+{
+public:
+    struct ScopeTime {
+        std::string name;
+        double last_ms{ 0.0 };    // sum of all uses of the scope in the last measured frame
+        double average_ms{ 0.0 }; // exponential moving average, GPU_PROFILER_SMOOTHING
+    };
+
+    // measures its lifetime
+    class Scope : private NonCopyable {
+    public:
+        Scope(GpuProfiler& profiler, std::string_view name) : profiler_{ profiler }, entry_{ profiler.begin(name) } {}
+        ~Scope() { profiler_.end(entry_); }
+    private:
+        GpuProfiler& profiler_;
+        size_t entry_;
+    };
+
+    GpuProfiler() = default;
+    ~GpuProfiler();
+
+    // call once per frame, outside of all scopes; beginFrame() also collects results of older frames
+    void beginFrame();
+    void endFrame();
+
+    // prefer Scope
+    size_t begin(std::string_view name);
+    void end(size_t entry);
+
+    // for benchmarks: no frame is dropped, beginFrame() waits for results of the oldest frame instead
+    void setWaitForResults(bool wait) { wait_for_results_ = wait; }
+
+    // in order of first use
+    const std::vector<ScopeTime>& getScopes() const { return scopes_; }
+    size_t getDroppedFrames() const { return dropped_frames_; }
+    uint64_t getMeasuredFrames() const { return measured_frames_; } // last_ms of scopes belongs to the last one
+
+    void log(std::ostream& out) const;
+
+private:
+    struct Entry {
+        size_t scope;
+        GLuint begin_query;
+        GLuint end_query{ 0 };
+    };
+
+    struct Frame {
+        std::vector<GLuint> queries; // pool, grows as needed
+        size_t used{ 0 };
+        std::vector<Entry> entries;
+        bool pending{ false };       // waits for results
+    };
+
+    GLuint next_query();
+    size_t scope_index(std::string_view name);
+    void collect(Frame& frame);
+
+    std::array<Frame, GPU_PROFILER_FRAMES> frames_;
+    size_t current_{ 0 };
+    std::vector<ScopeTime> scopes_;
+    std::vector<double> frame_ms_; // collect() scratch, by scope
+    size_t dropped_frames_{ 0 };
+    uint64_t measured_frames_{ 0 };
+    bool wait_for_results_{ false };
+    std::chrono::steady_clock::time_point last_log_{ std::chrono::steady_clock::now() };
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// FNV-1a, fast enough to be negligible compared to parsing or compiling;
+// pass the previous result as seed to hash several pieces
+inline uint64_t fnv1a(std::string_view data, uint64_t seed = 0xcbf29ce484222325ull) {
+    uint64_t hash = seed;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
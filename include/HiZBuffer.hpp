@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Config.hpp"
+#include "NonCopyable.hpp"
+#include "ShaderProgram.hpp"
+
+// Hierarchical depth (Hi-Z) occlusion test against the depth buffer of previous frames.
+// build() copies the depth of the rendered framebuffer and reduces it by compute shader (farthest depth
+// of 2x2 texels) down to at most HIZ_READBACK_WIDTH texels. That level is read back asynchronously
+// (PBO + fence, no stall) and fetch() builds the coarser levels on CPU from it.
+// Spheres are tested with the view-projection of the frame the depth came from, so the result is
+// a few frames old: an object coming out from behind an occluder may appear that many frames late.
+// Nothing is remembered between tests, a culled object is tested again next frame against newer depth.
+class HiZBuffer : private NonCopyable
+{
+public:
+    explicit HiZBuffer(std::shared_ptr<ShaderProgram> reduce_shader);
+    ~HiZBuffer();
+
+    // after the occluders are drawn into framebuffer (0 = default) of the viewport size
+    void build(GLuint framebuffer, GLsizei width, GLsizei height, const glm::mat4& view_projection);
+
+    // takes the newest finished readback, call before tests (not concurrently with them)
+    void fetch(void);
+
+    // for benchmarks: the tested depth is always HIZ_READBACK_BUFFERS - 1 frames old, independent of GPU
+    // timing, fetch() and build() wait for the readbacks instead of taking whatever is finished
+    void setWaitForResults(bool wait) { wait_for_results_ = wait; }
+
+    // forget the CPU pyramid, nothing is occluded until the next fetch()
+    void clear(void) { levels_.clear(); }
+
+    // true when the sphere was completely behind the depth; thread safe
+    bool isOccluded(const glm::vec3& center, float radius) const;
+
+private:
+    struct Readback {
+        GLuint buffer{ 0 };
+        GLsync fence{ nullptr };
+        glm::mat4 view_projection{ 1.0f };
+        uint64_t frame{ 0 };
+    };
+
+    void resize(GLsizei width, GLsizei height);
+    void release(void);
+
+    std::shared_ptr<ShaderProgram> reduce_shader_;
+    UniformHandle<GLint> source_level_;
+
+    // GPU side
+    GLsizei width_{ 0 }, height_{ 0 };
+    GLuint depth_texture_{ 0 };     // copy of the rendered depth
+    GLuint depth_framebuffer_{ 0 };
+    GLuint pyramid_{ 0 };           // level 0 = half resolution
+    GLsizei pyramid_levels_{ 0 };
+    glm::ivec2 readback_size_{ 0 }; // of the last level
+    Readback readbacks_[HIZ_READBACK_BUFFERS];
+    uint64_t frame_{ 0 };
+    bool wait_for_results_{ false };
+
+    // CPU side, level 0 = readback level; texel x of level 0 covers pixels [x * texel_pixels_, ...),
+    // the last one also the rest of the viewport
+    std::vector<std::vector<float>> levels_;
+    std::vector<glm::ivec2> level_sizes_;
+    glm::mat4 view_projection_{ 1.0f };
+    glm::vec2 viewport_{ 0.0f };
+    float texel_pixels_{ 1.0f };
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Config.hpp"
+#include "Mesh.hpp"
+#include "NonCopyable.hpp"
+#include "RenderStats.hpp"
+#include "ShaderProgram.hpp"
+
+// Many copies of the same meshes, each with its own transform and color. Instance data live in SSBO
+// at INSTANCE_DATA_BINDING, every mesh is drawn by one instanced call for all instances.
+// Needs shader reading instances[gl_InstanceID] (see instanced.vert).
+class InstancedModel : private NonCopyable {
+public:
+    // std430 layout, must match the shader
+    struct Instance {
+        glm::mat4 model_matrix{ 1.0f };
+        glm::vec4 color{ 1.0f };
+    };
+
+    InstancedModel() = default;
+    ~InstancedModel() {
+        glDeleteBuffers(1, &instance_buffer);
+    }
+
+    void addMesh(std::shared_ptr<Mesh> mesh, std::shared_ptr<ShaderProgram> shader) {
+        meshes.emplace_back(mesh_package{ mesh, shader, shader->getUniform<glm::mat4>("uDecode_m") });
+    }
+
+    // returns index of the instance
+    size_t addInstance(const glm::mat4& model_matrix, const glm::vec4& color = glm::vec4(1.0f)) {
+        instances.emplace_back(Instance{ model_matrix, color });
+        dirty = true;
+        return instances.size() - 1;
+    }
+
+    void setInstance(size_t index, const glm::mat4& model_matrix, const glm::vec4& color = glm::vec4(1.0f)) {
+        instances[index] = Instance{ model_matrix, color };
+        dirty = true;
+    }
+
+    void clearInstances() {
+        instances.clear();
+        dirty = true;
+    }
+
+    size_t getInstanceCount() const { return instances.size(); }
+
+    // needs bound FrameUniforms
+    void draw(RenderStats& stats) {
+        if (instances.empty() || meshes.empty())
+            return;
+        upload();
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INSTANCE_DATA_BINDING, instance_buffer);
+
+        for (auto& mesh_pkg : meshes) {
+            mesh_pkg.shader->use();
+            // compact vertices are decoded before the instance transform
+            mesh_pkg.decode_uniform.set(mesh_pkg.mesh->getDecodeMatrix());
+            mesh_pkg.mesh->drawInstanced(static_cast<GLsizei>(instances.size()));
+
+            size_t triangles = mesh_pkg.mesh->getTriangleCount() * instances.size();
+            stats.triangles_submitted += triangles;
+            stats.triangles_visible += triangles;
+            stats.draw_calls++;
+            stats.draw_commands++;
+        }
+    }
+
+private:
+    struct mesh_package {
+        std::shared_ptr<Mesh> mesh;
+        std::shared_ptr<ShaderProgram> shader;
+        UniformHandle<glm::mat4> decode_uniform;
+    };
+    std::vector<mesh_package> meshes;
+
+    std::vector<Instance> instances;
+    GLuint instance_buffer{ 0 };
+    size_t buffer_capacity{ 0 };    // in instances
+    bool dirty{ false };
+
+    // whole array is uploaded on any change, buffer grows by doubling
+    void upload() {
+        if (!dirty)
+            return;
+        if (instance_buffer == 0)
+            glCreateBuffers(1, &instance_buffer);
+        if (instances.size() > buffer_capacity) {
+            buffer_capacity = std::max(instances.size(), buffer_capacity * 2);
+            glNamedBufferData(instance_buffer, static_cast<GLsizeiptr>(buffer_capacity * sizeof(Instance)), nullptr, GL_DYNAMIC_DRAW);
+        }
+        glNamedBufferSubData(instance_buffer, 0, static_cast<GLsizeiptr>(instances.size() * sizeof(Instance)), instances.data());
+        dirty = false;
+    }
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Config.hpp"
+#include "NonCopyable.hpp"
+
+// Work-stealing job scheduler. Every worker owns a deque: it pushes and pops its own jobs at the back
+// (most recent first, data still in cache), idle workers steal the oldest jobs from the front of other deques.
+// A job is queued once all its dependencies are finished. Waiting inside a job (wait(), waitUntil(),
+// parallelFor()) executes queued jobs meanwhile, so it does not block a worker. Other threads (the GL thread)
+// only run the job they wait for, its dependencies and parallelFor() chunks, otherwise they block.
+// Long or blocking jobs (file parsing, camera) go to a separate background queue, run by at most all
+// workers but one, and never run by waiting.
+class JobSystem : private NonCopyable
+{
+    struct Job;
+
+public:
+    using Task = std::function<void()>;
+    // completion of a submitted job, dependency of other jobs
+    using JobHandle = std::shared_ptr<Job>;
+
+    // of one worker thread, since the previous sampleStats()
+    struct WorkerStats {
+        double utilization{ 0.0 }; // busy time / wall time
+        uint64_t jobs{ 0 };
+        uint64_t steals{ 0 };
+    };
+
+    // 0 = one worker per hardware thread except the calling one (at least one)
+    explicit JobSystem(unsigned int thread_count = JOB_SYSTEM_THREADS);
+    // runs all queued jobs, then stops the workers
+    ~JobSystem();
+
+    // task runs after all dependencies are finished, exceptions are logged and swallowed
+    JobHandle submit(Task task, std::initializer_list<JobHandle> dependencies = {});
+    // long or blocking task, see above
+    JobHandle submitBackground(Task task);
+
+    static bool isDone(const JobHandle& job);
+    void wait(const JobHandle& job);
+    void waitUntil(const std::function<bool()>& done);
+
+    // Fork-join: body(begin, end) over [0, count) in chunks of grain elements, the caller takes chunks too.
+    // Returns when all chunks are done, then rethrows the first exception thrown by the body.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& body);
+
+    unsigned int getThreadCount() const { return static_cast<unsigned int>(workers_.size()); }
+
+    // call from one thread only
+    std::vector<WorkerStats> sampleStats();
+
+private:
+    struct Job {
+        Task task;
+        std::atomic<uint32_t> pending{ 1 }; // unfinished dependencies, +1 until submit() returns
+        std::vector<JobHandle> dependencies; // not changed after submit()
+        bool background{ false };
+        std::atomic<bool> claimed{ false }; // taken for execution, queue entries of claimed jobs are skipped
+        std::atomic<bool> done{ false };
+        std::mutex mutex;                   // guards done and continuations
+        std::vector<JobHandle> continuations;
+    };
+
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<JobHandle> jobs;
+
+        std::atomic<uint64_t> busy_ns{ 0 };
+        std::atomic<uint64_t> executed{ 0 };
+        std::atomic<uint64_t> steals{ 0 };
+        uint64_t sampled_busy_ns{ 0 }, sampled_jobs{ 0 }, sampled_steals{ 0 };
+    };
+
+    static constexpr unsigned int not_a_worker{ ~0u };
+
+    void worker_func(unsigned int index);
+    unsigned int worker_index() const;
+    void enqueue(JobHandle job);
+    bool run_one(unsigned int self);
+    bool run_background(unsigned int self);
+    bool background_runnable() const { return background_queued_ > 0 && background_running_ < background_limit_; }
+    void help(const JobHandle& job);
+    void execute(const JobHandle& job, unsigned int self);
+
+    std::vector<std::unique_ptr<Queue>> queues_; // one per worker
+    std::vector<std::thread> workers_;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+    std::atomic<size_t> queued_{ 0 };
+
+    std::mutex background_mutex_;
+    std::deque<JobHandle> background_jobs_;
+    std::atomic<size_t> background_queued_{ 0 };
+    std::atomic<unsigned int> background_running_{ 0 };
+    unsigned int background_limit_{ 1 };
+
+    // blocked non-worker threads, woken when a job finishes
+    std::mutex done_mutex_;
+    std::condition_variable done_cv_;
+    std::atomic<unsigned int> waiters_{ 0 };
+    std::atomic<unsigned int> next_queue_{ 0 }; // for jobs submitted from other threads
+    bool terminate_{ false };
+
+    std::chrono::steady_clock::time_point sample_time_{ std::chrono::steady_clock::now() };
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <filesystem>
+#include <string_view>
+#include <cstddef>
+
+#include "NonCopyable.hpp"
+
+// Read-only memory mapping of whole file.
+// The mapping lives as long as the object, views returned by view() must not outlive it.
+class MappedFile : private NonCopyable
+{
+public:
+    MappedFile() = default;
+    MappedFile(const std::filesystem::path& filename);
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator = (MappedFile&& other) noexcept;
+    ~MappedFile();
+
+    bool is_open(void) const { return is_open_; }
+    const char* data(void) const { return data_; }
+    size_t size(void) const { return size_; }
+    std::string_view view(void) const { return std::string_view(data_, size_); }
+
+    void close(void);
+
+private:
+    const char* data_{ nullptr };
+    size_t size_{ 0 };
+    bool is_open_{ false };
+
+#ifdef _WIN32
+    void* file_handle_{ nullptr };
+    void* mapping_handle_{ nullptr };
+#endif
+};
@@ -1,90 +1,319 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
+#include <span>
 
 #include <GL/glew.h>
-#include <glm/glm.hpp> 
+#include <glm/glm.hpp>
 #include <glm/ext.hpp>
+#include <glm/gtc/packing.hpp>
 
-#include "assets.hpp"
+#include "Assets.hpp"
+#include "Config.hpp"
+#include "Frustum.hpp"
+#include "GeometryArena.hpp"
 #include "NonCopyable.hpp"
+#include "RenderStats.hpp"
+#include "VertexLayout.hpp"
 
 class Mesh : private NonCopyable
 {
 public:
     // force attribute slots in shaders for all meshes, shaders etc.
-    static constexpr GLuint attribute_location_position{ 0 };
-    static constexpr GLuint attribute_location_normal{ 1 };
-    static constexpr GLuint attribute_location_texture_coords{ 2 };
+    static constexpr GLuint attribute_location_position{ vertex_attribute_position };
+    static constexpr GLuint attribute_location_normal{ vertex_attribute_normal };
+    static constexpr GLuint attribute_location_texture_coords{ vertex_attribute_texture_coords };
 
-    // No default constructor 
+    using VertexFormat = ::VertexFormat;
+    static constexpr VertexFormat default_vertex_format{ ::default_vertex_format };
+
+    // index range of one multi-draw command, relative to the first index of the mesh
+    struct DrawRange {
+        GLuint first_index;
+        GLsizei index_count;
+    };
+
+    // No default constructor
     Mesh() = delete;
 
-    Mesh(std::vector<Vertex> const& vertices, GLenum primitive_type) : primitive_type_{ primitive_type }
+    Mesh(std::span<const Vertex> vertices, GLenum primitive_type, VertexFormat format = default_vertex_format) :
+        Mesh{ vertices, primitive_type, AABB::of(vertices), format } {}
+
+    Mesh(std::span<const Vertex> vertices, GLenum primitive_type, const AABB& bounds, VertexFormat format = default_vertex_format) :
+        Mesh{ vertices.size(), 0, primitive_type, bounds, format }
     {
-        glCreateVertexArrays(1, &vao_);
+        sphere_ = BoundingSphere::of(vertices, bounds_);
+        uploadVertices(0, vertices);
+    }
 
-        glVertexArrayAttribFormat(vao_, attribute_location_position, glm::vec3::length(), GL_FLOAT, GL_FALSE, offsetof(Vertex, position));
-        glVertexArrayAttribBinding(vao_, attribute_location_position, 0);
-        glEnableVertexArrayAttrib(vao_, attribute_location_position);
+    // Mesh with indirect vertex addressing. Needs compiled shader for attributes setup.
+    Mesh(std::span<const Vertex> vertices, std::span<const GLuint> indices, GLenum primitive_type, VertexFormat format = default_vertex_format) :
+        Mesh{ vertices, indices, primitive_type, AABB::of(vertices), format } {}
 
-        glVertexArrayAttribFormat(vao_, attribute_location_normal, glm::vec3::length(), GL_FLOAT, GL_FALSE, offsetof(Vertex, normal));
-        glVertexArrayAttribBinding(vao_, attribute_location_normal, 0);
-        glEnableVertexArrayAttrib(vao_, attribute_location_normal);
+    Mesh(std::span<const Vertex> vertices, std::span<const GLuint> indices, GLenum primitive_type, const AABB& bounds, VertexFormat format = default_vertex_format) :
+        Mesh{ vertices.size(), indices.size(), primitive_type, bounds, format }
+    {
+        sphere_ = BoundingSphere::of(vertices, bounds_);
+        uploadVertices(0, vertices);
+        uploadIndices(0, indices);
+    }
 
-        glVertexArrayAttribFormat(vao_, attribute_location_texture_coords, glm::vec2::length(), GL_FLOAT, GL_FALSE, offsetof(Vertex, texCoords));
-        glVertexArrayAttribBinding(vao_, attribute_location_texture_coords, 0);
-        glEnableVertexArrayAttrib(vao_, attribute_location_texture_coords);
+    // Mesh with allocated, but uninitialized buffers. Fill them by parts with uploadVertices() / uploadIndices()
+    // before first draw (used for streaming of big meshes over several frames).
+    // Vertices must lie within bounds when the compact format is used.
+    Mesh(size_t vertex_count, size_t index_count, GLenum primitive_type, const AABB& bounds, VertexFormat format = default_vertex_format) :
+        primitive_type_{ primitive_type }, bounds_{ bounds }, sphere_{ BoundingSphere::of(bounds) }, format_{ format }
+    {
+        init_decode();
+        create_vertex_buffer(vertex_count);
+        if (index_count > 0) {
+            index_type_ = (MESH_SHORT_INDICES && vertex_count <= 0x10000) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+            create_index_buffer(index_count);
+        }
+    }
 
-        glCreateBuffers(1, &vbo_);
-        GLsizeiptr vbo_size = static_cast<GLsizeiptr>(vertices.size() * sizeof(Vertex));
-        glNamedBufferData(vbo_, vbo_size, vertices.data(), GL_STATIC_DRAW);
+    // Mesh sub-allocated in the shared arena (vertex format of the arena). Falls back to own buffers when the arena is full.
+    Mesh(std::shared_ptr<GeometryArena> arena, size_t vertex_count, size_t index_count, GLenum primitive_type, const AABB& bounds) :
+        primitive_type_{ primitive_type }, bounds_{ bounds }, sphere_{ BoundingSphere::of(bounds) }, format_{ arena->getVertexFormat() }
+    {
+        init_decode();
+        if (index_count > 0)
+            index_type_ = (MESH_SHORT_INDICES && vertex_count <= 0x10000) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
 
-        glVertexArrayVertexBuffer(vao_, 0, vbo_, 0, sizeof(Vertex));
+        allocation_ = arena->allocate(vertex_count, index_count, index_type_);
+        if (!allocation_) {
+            std::cerr << "Geometry arena is full, mesh uses own buffers\n";
+            create_vertex_buffer(vertex_count);
+            if (index_count > 0)
+                create_index_buffer(index_count);
+            return;
+        }
+        arena_ = std::move(arena);
+        vao_ = arena_->getVertexArray(index_type_);
+        vbo_ = arena_->getVertexBuffer();
+        ebo_ = index_count > 0 ? arena_->getIndexBuffer(index_type_) : 0;
+        base_vertex_ = static_cast<GLint>(allocation_->first_vertex);
+        first_index_ = static_cast<GLuint>(allocation_->first_index);
+        count_ = static_cast<GLsizei>(index_count > 0 ? index_count : vertex_count);
+    }
 
-        // store vertex count 
-        count_ = static_cast<GLsizei>(vertices.size());
+    void uploadVertices(size_t first_vertex, std::span<const Vertex> vertices) {
+        if (format_ == VertexFormat::full) {
+            glNamedBufferSubData(vbo_, static_cast<GLintptr>((base_vertex_ + first_vertex) * sizeof(Vertex)), static_cast<GLsizeiptr>(vertices.size_bytes()), vertices.data());
+            return;
+        }
+        std::vector<CompactVertex> packed(vertices.size());
+        std::transform(vertices.begin(), vertices.end(), packed.begin(), [this](const Vertex& v) { return pack(v); });
+        glNamedBufferSubData(vbo_, static_cast<GLintptr>((base_vertex_ + first_vertex) * sizeof(CompactVertex)), static_cast<GLsizeiptr>(packed.size() * sizeof(CompactVertex)), packed.data());
     }
 
-    // Mesh with indirect vertex addressing. Needs compiled shader for attributes setup. 
-    Mesh(std::vector<Vertex> const& vertices, std::vector<GLuint> const& indices, GLenum primitive_type) :
-        Mesh{ vertices, primitive_type }
-    {
-        glCreateBuffers(1, &ebo_);
-        GLsizeiptr ebo_size = static_cast<GLsizeiptr>(indices.size() * sizeof(GLuint));
-        glNamedBufferData(ebo_, ebo_size, indices.data(), GL_STATIC_DRAW);
+    void uploadIndices(size_t first_index, std::span<const GLuint> indices) {
+        if (index_type_ == GL_UNSIGNED_INT) {
+            glNamedBufferSubData(ebo_, static_cast<GLintptr>((first_index_ + first_index) * sizeof(GLuint)), static_cast<GLsizeiptr>(indices.size_bytes()), indices.data());
+            return;
+        }
+        std::vector<GLushort> narrow(indices.begin(), indices.end());
+        glNamedBufferSubData(ebo_, static_cast<GLintptr>((first_index_ + first_index) * sizeof(GLushort)), static_cast<GLsizeiptr>(narrow.size() * sizeof(GLushort)), narrow.data());
+    }
 
-        glVertexArrayElementBuffer(vao_, ebo_);
+    // index ranges of levels of detail, level 0 = full detail (see generateLods())
+    void setLods(std::span<const MeshLod> lods) { lods_.assign(lods.begin(), lods.end()); }
+    unsigned int getLodCount() const { return lods_.empty() ? 1 : static_cast<unsigned int>(lods_.size()); }
 
-        // store indices count 
-        count_ = static_cast<GLsizei>(indices.size());
+    size_t getTriangleCount(unsigned int lod = 0) const {
+        if (lods_.empty())
+            return static_cast<size_t>(count_) / 3;
+        return lods_[std::min<size_t>(lod, lods_.size() - 1)].index_count / 3;
     }
 
-    void draw() {
+    // clusters of LOD 0 for selectRanges()
+    void setMeshlets(std::span<const Meshlet> meshlets) { meshlets_.assign(meshlets.begin(), meshlets.end()); }
+    bool hasMeshlets() const { return !meshlets_.empty(); }
+
+    void draw(unsigned int lod = 0) {
         glBindVertexArray(vao_);
         if (ebo_ == 0) {
-            glDrawArrays(primitive_type_, 0, count_);
+            glDrawArrays(primitive_type_, base_vertex_, count_);
+            return;
         }
-        else {
-            glDrawElements(primitive_type_, count_, GL_UNSIGNED_INT, nullptr);
+        DrawRange range = lod_range(lod);
+        glDrawElementsBaseVertex(primitive_type_, range.index_count, index_type_,
+            reinterpret_cast<const void*>((first_index_ + range.first_index) * getIndexSize()), base_vertex_);
+    }
+
+    // all instances in one call, per-instance data are up to the shader (see InstancedModel)
+    void drawInstanced(GLsizei instance_count, unsigned int lod = 0) {
+        glBindVertexArray(vao_);
+        if (ebo_ == 0) {
+            glDrawArraysInstanced(primitive_type_, base_vertex_, count_, instance_count);
+            return;
         }
+        DrawRange range = lod_range(lod);
+        glDrawElementsInstancedBaseVertex(primitive_type_, range.index_count, index_type_,
+            reinterpret_cast<const void*>((first_index_ + range.first_index) * getIndexSize()), instance_count, base_vertex_);
+    }
+
+    // Index range of the LOD (appended to ranges), non-indexed meshes get a range of vertices.
+    void selectRanges(unsigned int lod, RenderStats& stats, std::vector<DrawRange>& ranges) const {
+        size_t triangles = getTriangleCount(lod);
+        stats.triangles_submitted += triangles;
+        stats.triangles_visible += triangles;
+        ranges.push_back(ebo_ == 0 ? DrawRange{ 0, count_ } : lod_range(lod));
     }
 
+    // Index ranges of LOD 0 without the meshlets outside the frustum or facing away from the camera, visible neighbours
+    // are merged into one range. Frustum and camera position are in model space (i.e. without the decode matrix).
+    void selectRanges(const Frustum& frustum, const glm::vec3& camera_position, RenderStats& stats, std::vector<DrawRange>& ranges) const {
+        if (ebo_ == 0 || meshlets_.empty()) {
+            selectRanges(0, stats, ranges);
+            return;
+        }
+
+        size_t end_of_last = 0;
+        bool merge = false;
+        for (const auto& meshlet : meshlets_) {
+            stats.meshlets_submitted++;
+            stats.triangles_submitted += meshlet.index_count / 3;
+
+            if (!frustum.intersectsSphere(meshlet.center, meshlet.radius))
+                continue;
+            if (MESHLET_CONE_CULLING) {
+                glm::vec3 direction = meshlet.center - camera_position;
+                if (glm::dot(direction, meshlet.cone_axis) >= meshlet.cone_cutoff * glm::length(direction) + meshlet.radius)
+                    continue;
+            }
+            stats.meshlets_visible++;
+            stats.triangles_visible += meshlet.index_count / 3;
+
+            if (merge && end_of_last == meshlet.first_index)
+                ranges.back().index_count += static_cast<GLsizei>(meshlet.index_count);
+            else
+                ranges.push_back(DrawRange{ meshlet.first_index, static_cast<GLsizei>(meshlet.index_count) });
+            merge = true;
+            end_of_last = meshlet.first_index + meshlet.index_count;
+        }
+    }
+
+    // model space bounds
+    const AABB& getBounds() const { return bounds_; }
+
+    // model space, defaults to the sphere around bounds (the tight one is computed at load time)
+    void setBoundingSphere(const BoundingSphere& sphere) {
+        if (!sphere.empty())
+            sphere_ = sphere;
+    }
+    const BoundingSphere& getBoundingSphere() const { return sphere_; }
+
+    // maps vertex positions as stored on GPU to model space, identity for full format
+    // (uniform scale, so normal matrix of the model stays valid)
+    const glm::mat4& getDecodeMatrix() const { return decode_matrix_; }
+
+    // sizes on GPU
+    size_t getVertexSize() const { return vertexSize(format_); }
+    size_t getIndexSize() const { return index_type_ == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint); }
+
+    // GPU placement, for RenderQueue (vertex array and buffers are shared by all meshes of the arena)
+    GLuint getVertexArray() const { return vao_; }
+    GLenum getPrimitiveType() const { return primitive_type_; }
+    GLenum getIndexType() const { return index_type_; }
+    bool hasIndices() const { return ebo_ != 0; }
+    GLint getBaseVertex() const { return base_vertex_; }
+    GLuint getFirstIndex() const { return first_index_; }
+
     ~Mesh() {
+        if (arena_) {
+            arena_->release(*allocation_);
+            return;
+        }
         glDeleteBuffers(1, &ebo_);
         glDeleteBuffers(1, &vbo_);
         glDeleteVertexArrays(1, &vao_);
     }
 
 private:
+    DrawRange lod_range(unsigned int lod) const {
+        if (lods_.empty())
+            return DrawRange{ 0, count_ };
+        const auto& range = lods_[std::min<size_t>(lod, lods_.size() - 1)];
+        return DrawRange{ range.first_index, static_cast<GLsizei>(range.index_count) };
+    }
+
+    void init_decode() {
+        if (format_ == VertexFormat::full || bounds_.empty())
+            return;
+        decode_offset_ = bounds_.min_point;
+        glm::vec3 size = bounds_.max_point - bounds_.min_point;
+        decode_scale_ = std::max({ size.x, size.y, size.z });
+        if (decode_scale_ <= 0.0f)
+            decode_scale_ = 1.0f;
+        decode_matrix_ = glm::scale(glm::translate(glm::mat4(1.0f), decode_offset_), glm::vec3(decode_scale_));
+    }
+
+    CompactVertex pack(const Vertex& vertex) const {
+        CompactVertex packed{};
+        for (int i = 0; i < 3; i++) {
+            float position = std::clamp((vertex.position[i] - decode_offset_[i]) / decode_scale_, 0.0f, 1.0f);
+            packed.position[i] = static_cast<uint16_t>(std::lround(position * 65535.0f));
+        }
+        packed.normal = glm::packSnorm3x10_1x2(glm::vec4(vertex.normal, 0.0f));
+        packed.texCoords = glm::packHalf2x16(vertex.texCoords);
+        return packed;
+    }
+
+    void create_vertex_buffer(size_t vertex_count) {
+        glCreateVertexArrays(1, &vao_);
+        setupVertexAttributes(vao_, format_);
+
+        glCreateBuffers(1, &vbo_);
+        GLsizeiptr vbo_size = static_cast<GLsizeiptr>(vertex_count * getVertexSize());
+        glNamedBufferData(vbo_, vbo_size, nullptr, GL_STATIC_DRAW);
+
+        glVertexArrayVertexBuffer(vao_, 0, vbo_, 0, static_cast<GLsizei>(getVertexSize()));
+
+        // store vertex count
+        count_ = static_cast<GLsizei>(vertex_count);
+    }
+
+    void create_index_buffer(size_t index_count) {
+        glCreateBuffers(1, &ebo_);
+        GLsizeiptr ebo_size = static_cast<GLsizeiptr>(index_count * getIndexSize());
+        glNamedBufferData(ebo_, ebo_size, nullptr, GL_STATIC_DRAW);
+
+        glVertexArrayElementBuffer(vao_, ebo_);
+
+        // store indices count
+        count_ = static_cast<GLsizei>(index_count);
+    }
+
     //safe defaults
     GLenum primitive_type_{ GL_POINTS };
     GLsizei count_{ 0 };
+    AABB bounds_;
+    BoundingSphere sphere_;
+
+    VertexFormat format_{ VertexFormat::full };
+    GLenum index_type_{ GL_UNSIGNED_INT };
+    glm::vec3 decode_offset_{ 0.0f };
+    float decode_scale_{ 1.0f };
+    glm::mat4 decode_matrix_{ 1.0f };
+    std::vector<MeshLod> lods_;
+    std::vector<Meshlet> meshlets_;
+
+    // placement in the shared arena, zero offsets for own buffers
+    std::shared_ptr<GeometryArena> arena_;
+    std::optional<GeometryArena::Allocation> allocation_;
+    GLint base_vertex_{ 0 };
+    GLuint first_index_{ 0 };
 
     // OpenGL buffer IDs
     // ID = 0 is reserved (i.e. uninitalized)
     GLuint vao_{ 0 };
     GLuint vbo_{ 0 };
     GLuint ebo_{ 0 };
-};
\ No newline at end of file
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+#include <GL/glew.h>
+
+#include "Assets.hpp"
+#include "MappedFile.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+#include "ObjectLoader.hpp"
+
+// Binary mesh cache stored next to the source file ("<source>.meshbin").
+// Layout: MeshCacheHeader | MeshCacheSubmesh[submesh_count] | Vertex[vertex_count] | GLuint[index_count] | Meshlet[meshlet_count]
+// Blobs are stored exactly as glNamedBufferData() expects them, indices are local to each submesh.
+
+#define MESH_CACHE_EXTENSION ".meshbin"
+#define MESH_CACHE_VERSION 8
+#define MESH_CACHE_MAX_LODS 8
+
+// MeshCacheHeader::flags
+#define MESH_CACHE_FLAG_VERTEX_CACHE 0x1
+#define MESH_CACHE_FLAG_OVERDRAW 0x2
+#define MESH_CACHE_FLAG_VERTEX_FETCH 0x4
+
+struct MeshCacheAttribute {
+    uint32_t location;   // attribute slot, see Mesh::attribute_location_*
+    uint32_t components; // 1..4
+    uint32_t type;       // GL_FLOAT, ...
+    uint32_t offset;     // offset in vertex
+};
+
+struct MeshCacheHeader {
+    char magic[4];       // "ICPM"
+    uint32_t version;
+
+    // cache key
+    uint64_t source_path_hash;
+    int64_t  source_mtime;
+    uint64_t source_size;
+    uint64_t source_content_hash;
+
+    // vertex layout
+    uint32_t vertex_stride;
+    uint32_t attribute_count;
+    MeshCacheAttribute attributes[4];
+
+    // blobs (sum of all submeshes)
+    uint64_t vertex_count;
+    uint64_t index_count;
+    uint32_t index_type;
+    uint32_t submesh_count;
+
+    // MESH_CACHE_FLAG_*, optimizations applied to the data
+    uint32_t flags;
+    uint32_t lod_settings_hash;
+
+    // MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES, MESHLET_MIN_MESH_TRIANGLES
+    uint32_t meshlet_limits[3];
+    uint32_t load_settings_hash; // OBJLoadSettings affecting the result (weld, group splitting)
+    uint64_t meshlet_count;
+
+    uint32_t optimize_cache_size; // MeshOptimizeSettings::cache_size, 0 = not optimized
+    uint32_t reserved;
+};
+
+struct MeshCacheSubmesh {
+    char name[64];       // zero terminated, truncated if longer
+    uint64_t first_vertex;
+    uint64_t vertex_count;
+    uint64_t first_index;
+    uint64_t index_count;
+    float bounds_min[3];
+    float bounds_max[3];
+    float sphere[4];     // center, radius
+    uint32_t lod_count;
+    MeshLod lods[MESH_CACHE_MAX_LODS];
+    uint64_t first_meshlet;
+    uint64_t meshlet_count;
+};
+static_assert(sizeof(MeshCacheHeader) % alignof(Vertex) == 0 && sizeof(MeshCacheSubmesh) % alignof(Vertex) == 0,
+    "blobs following the header must stay aligned");
+
+struct CachedSubmesh {
+    std::string name;
+    std::span<const Vertex> vertices;
+    std::span<const GLuint> indices; // all LODs
+    AABB bounds;
+    BoundingSphere sphere;
+    std::vector<MeshLod> lods;
+    std::span<const Meshlet> meshlets;
+};
+
+// CPU side geometry ready for upload. Data are either owned (freshly parsed),
+// or a view into memory mapped cache file. Spans stay valid when the object is moved.
+struct CachedMesh {
+    std::vector<CachedSubmesh> submeshes;
+    bool from_cache{ false };
+
+    std::vector<SubmeshData> storage;
+    MappedFile mapping;
+};
+
+std::filesystem::path meshCachePath(const std::filesystem::path& source);
+
+// Loads mesh from the binary cache, if the cache is missing or stale, parses the source,
+// optimizes it, generates LODs and meshlets and regenerates the cache. Cache made with different optimize or LOD settings is stale.
+bool loadMeshCached(const std::filesystem::path& source, CachedMesh& mesh, const OBJLoadSettings& settings = {},
+    const MeshOptimizeSettings& optimize = {}, const MeshLodSettings& lod_settings = {});
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <GL/glew.h>
+
+#include "Assets.hpp"
+#include "Config.hpp"
+
+struct MeshOptimizeSettings {
+	bool vertex_cache{ MESH_OPTIMIZE_VERTEX_CACHE };     // reorder triangles for post-transform vertex cache
+	bool overdraw{ MESH_OPTIMIZE_OVERDRAW };             // reorder triangle clusters, outer surfaces first
+	bool vertex_fetch{ MESH_OPTIMIZE_VERTEX_FETCH };     // reorder vertices by first use
+	unsigned int cache_size{ MESH_OPTIMIZE_CACHE_SIZE }; // simulated FIFO cache size
+
+	bool enabled() const { return vertex_cache || overdraw || vertex_fetch; }
+};
+
+struct VertexCacheStats {
+	float acmr{ 0.0f }; // average cache miss ratio = transformed vertices / triangles (0.5 .. 3, lower is better)
+	float atvr{ 0.0f }; // average transform to vertex ratio = transformed vertices / vertices (1 is optimum)
+};
+
+// simulates FIFO post-transform vertex cache
+VertexCacheStats analyzeVertexCache(std::span<const GLuint> indices, size_t vertex_count, unsigned int cache_size = MESH_OPTIMIZE_CACHE_SIZE);
+
+// Tipsify (Sander, Nehab, Barczak: Fast Triangle Reordering for Vertex Locality and Reduced Overdraw, 2007).
+// Returns start triangles of clusters (parts between dead-ends), usable for overdraw ordering.
+std::vector<size_t> optimizeVertexCache(std::vector<GLuint>& indices, size_t vertex_count, unsigned int cache_size = MESH_OPTIMIZE_CACHE_SIZE);
+
+// Reorders clusters so that those facing away from the mesh center (likely occluders) are drawn first.
+void optimizeOverdraw(std::vector<GLuint>& indices, std::span<const Vertex> vertices, const std::vector<size_t>& clusters);
+
+// Reorders vertices by first use in the index buffer, unused vertices are removed.
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
+
+// Reorders triangles into meshlets (contiguous index ranges) grown over shared vertices, preferring similar
+// normals, computes their bounding spheres and normal cones. Seeds follow the current triangle order,
+// so run it after vertex cache optimization.
+std::vector<Meshlet> buildMeshlets(std::span<const Vertex> vertices, std::span<GLuint> indices,
+	size_t max_vertices = MESHLET_MAX_VERTICES, size_t max_triangles = MESHLET_MAX_TRIANGLES);
+
+// all enabled passes in proper order, prints ACMR/ATVR before and after
+void optimizeMesh(SubmeshData& submesh, const MeshOptimizeSettings& settings = {});
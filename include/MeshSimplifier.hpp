@@ -0,0 +1,27 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <GL/glew.h>
+
+#include "Assets.hpp"
+#include "Config.hpp"
+
+struct MeshLodSettings {
+	unsigned int count{ MESH_LOD_COUNT };       // levels including the original mesh, 1 = no LODs
+	float reduction{ MESH_LOD_REDUCTION };      // triangle count ratio of consecutive levels
+	float max_error{ MESH_LOD_MAX_ERROR };      // max. geometric error relative to mesh size
+
+	bool enabled() const { return count > 1; }
+};
+
+// Quadric error metric edge collapse (Garland, Heckbert: Surface Simplification Using Quadric Error Metrics, 1997).
+// Vertices are only collapsed into their neighbours, no new vertices are created, so the result indexes
+// the same vertex buffer. Borders and attribute seams (more vertices at one position) are kept.
+// Stops at target_index_count or when the next collapse would exceed max_error.
+std::vector<GLuint> simplifyMesh(std::span<const Vertex> vertices, std::span<const GLuint> indices,
+	size_t target_index_count, float max_error, float* result_error = nullptr);
+
+// Appends simplified index lists to submesh.indices and describes all levels in submesh.lods.
+// Generation stops early when a level can not be reduced any more within max_error.
+void generateLods(SubmeshData& submesh, const MeshLodSettings& settings = {});
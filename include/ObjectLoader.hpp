@@ -5,7 +5,33 @@
 #include <GL/glew.h>
 
 #include "Assets.hpp"
+#include "Config.hpp"
 
+class JobSystem;
+
+struct OBJLoadSettings {
+	// 0 = weld only vertices with identical attributes (position, normal, texture coords)
+	// >0 = positional weld, merge vertices whose attributes differ by at most epsilon
+	float weld_epsilon{ 0.0f };
+
+	// split big files into chunks parsed concurrently (same result as serial parsing)
+	bool parallel{ OBJ_LOADER_PARALLEL };
+	unsigned int thread_count{ 0 }; // 0 = number of hardware threads (workers + caller with jobs)
+	JobSystem* jobs{ nullptr };     // chunks run as jobs, own threads without it
+
+	// every distinct combination of object (o), group (g) and material (usemtl) becomes separate submesh
+	bool split_groups{ true };
+};
+
+// Supported: v, vt, vn, faces with any number of corners (triangulated as a fan)
+// in v, v/vt, v//vn and v/vt/vn forms, negative (relative) indices, o, g, usemtl.
+// Missing normals are computed from faces, missing texture coords are set to zero.
+bool loadOBJ(const std::filesystem::path& filename,
+	std::vector <SubmeshData>& submeshes,
+	const OBJLoadSettings& settings = {});
+
+// whole file as single mesh
 bool loadOBJ(const std::filesystem::path& filename,
 	std::vector <Vertex>& vertices,
-	std::vector <GLuint>& indices);
+	std::vector <GLuint>& indices,
+	const OBJLoadSettings& settings = {});
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Config.hpp"
+#include "Mesh.hpp"
+#include "NonCopyable.hpp"
+#include "RenderStats.hpp"
+#include "ShaderProgram.hpp"
+
+// Collects draw items of one frame, sorts them by a packed 64-bit key and submits them in that order.
+// Key (from the most significant bits): shader program | vertex array | primitive | depth, so all draws
+// with the same state become one glMultiDrawElementsIndirect() with commands front to back (opaque only).
+// Per-draw data are stored in SSBO at MULTIDRAW_DRAW_DATA_BINDING, the shader reads them by gl_BaseInstance.
+class RenderQueue : private NonCopyable
+{
+public:
+    // std430 layout, must match the shader
+    struct DrawData {
+        glm::mat4 model_matrix;
+        glm::vec4 tint{ 1.0f };
+    };
+
+    RenderQueue() = default;
+    ~RenderQueue();
+
+    // all ranges of the mesh share one DrawData, depth is the distance from camera (view space)
+    void add(const std::shared_ptr<ShaderProgram>& shader, const Mesh& mesh, std::span<const Mesh::DrawRange> ranges, const DrawData& data, float depth);
+
+    // sorts, draws and clears the queue; state changes and draw calls are counted to stats
+    void submit(RenderStats& stats);
+
+private:
+    // GL layouts of indirect commands
+    struct DrawElementsCommand {
+        GLuint count;
+        GLuint instance_count;
+        GLuint first_index;
+        GLint base_vertex;
+        GLuint base_instance;
+    };
+    struct DrawArraysCommand {
+        GLuint count;
+        GLuint instance_count;
+        GLuint first;
+        GLuint base_instance;
+    };
+
+    struct Item {
+        uint64_t key;
+        ShaderProgram* shader;
+        GLuint program;
+        GLuint vao;
+        GLenum primitive_type;
+        GLenum index_type; // 0 = not indexed
+        GLint base_vertex;
+        GLuint first_index;
+        uint32_t first_range; // in ranges_
+        uint32_t range_count;
+        uint32_t draw_data;   // index in draw_data_, base instance of the commands
+    };
+
+    // commands in sorted order, one run of items with the same state = one multi-draw
+    struct Run {
+        size_t first_item;
+        size_t offset;  // in commands_
+        size_t count;   // commands
+    };
+
+    static uint64_t make_key(GLuint program, GLuint vao, GLenum primitive_type, float depth);
+
+    std::vector<Item> items_;
+    std::vector<Mesh::DrawRange> ranges_;
+    std::vector<DrawData> draw_data_;
+    std::vector<char> commands_; // all items, uploaded at once
+    std::vector<Run> runs_;
+    std::vector<std::shared_ptr<ShaderProgram>> shaders_; // keeps shaders of queued items alive
+
+    GLuint draw_data_buffer_{ 0 };
+    GLuint command_buffer_{ 0 };
+};
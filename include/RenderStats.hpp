@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+
+// per frame counters, reset before drawing
+struct RenderStats {
+    size_t meshes_visible{ 0 };      // after frustum culling of whole meshes
+    size_t meshes_culled{ 0 };
+    size_t meshes_occluded{ 0 };     // in the frustum, but behind the depth of previous frames
+    size_t triangles_submitted{ 0 }; // triangles of drawn meshes (selected LOD) before cluster culling
+    size_t triangles_visible{ 0 };   // triangles sent to GPU
+    size_t meshlets_submitted{ 0 };
+    size_t meshlets_visible{ 0 };
+    size_t draw_calls{ 0 };          // multi-draw calls
+    size_t draw_commands{ 0 };       // ranges drawn by them
+    size_t shader_changes{ 0 };      // by RenderQueue, after sorting
+    size_t vertex_array_changes{ 0 };
+    size_t transforms_updated{ 0 };  // world matrices recomputed by TransformSystem
+
+    void reset(void) { *this = RenderStats{}; }
+};
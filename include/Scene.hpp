@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "Assets.hpp"
+#include "FrustumCuller.hpp"
+#include "JobSystem.hpp"
+#include "Mesh.hpp"
+#include "NonCopyable.hpp"
+#include "RenderQueue.hpp"
+#include "RenderStats.hpp"
+#include "ShaderProgram.hpp"
+#include "TransformSystem.hpp"
+
+// generational ID: slot in the scene and its generation, default = no object
+struct SceneId {
+    uint32_t slot{ std::numeric_limits<uint32_t>::max() };
+    uint32_t generation{ 0 };
+
+    bool operator == (const SceneId&) const = default;
+};
+
+// Scene objects stored in dense arrays (structure of arrays) and addressed by generational IDs. A destroyed
+// object's slot is reused with a new generation, so stale IDs are detected. Objects are swap-removed, and
+// update, cull and draw stream linearly through the arrays. Names are only a side index.
+// A model is an object without geometry. Each of its meshes is a child object that refers to the mesh
+// and shader by an index into a table. Table entries are counted and released with the last object using them.
+class Scene : private NonCopyable
+{
+public:
+    using Id = SceneId;
+
+    Scene() = default;
+
+    // object without geometry, name must be unique (empty = unnamed)
+    Id create(const std::string& name = {}, Id parent = {});
+    // child object drawing the mesh, transform relative to the parent
+    Id addMesh(Id parent, std::shared_ptr<Mesh> mesh, std::shared_ptr<ShaderProgram> shader,
+        glm::vec3 origin = glm::vec3(0.0f), glm::vec3 eulerAngles = glm::vec3(0.0f), glm::vec3 scale = glm::vec3(1.0f));
+    // destroys the object with all its children
+    void destroy(Id id);
+
+    bool contains(Id id) const;
+    // default (invalid) Id if there is no such object
+    Id find(const std::string& name) const;
+    const std::unordered_map<std::string, Id>& getNames() const { return names_; }
+    size_t size() const { return ids_.size(); }
+
+    void setPosition(Id id, const glm::vec3& position);
+    void setEulerAngles(Id id, const glm::vec3& eulerAngles); // pitch, yaw, roll
+    void setScale(Id id, const glm::vec3& scale);
+    // for complex (externally provided) transformations
+    void setModelMatrix(Id id, const glm::mat4& model_matrix);
+    void translate(Id id, const glm::vec3& offset);
+    void rotate(Id id, const glm::vec3& pitch_yaw_roll_offs);
+    void scale(Id id, const glm::vec3& scale_offs);
+
+    // coarsest level of detail of the object and its children used in the last frame
+    unsigned int getLod(Id id) const;
+
+    // world matrices of moved objects, once per frame before cull()
+    void update(RenderStats& stats);
+
+    // adds world space bounding spheres of all meshes to the culler (computed in parallel chunks),
+    // call before draw() every frame
+    void cull(FrustumCuller& culler, JobSystem& jobs);
+
+    // Meshes outside the frustum (tested by culler) are skipped.
+    // View and projection select level of detail of each mesh and cull meshlets of full detail meshes,
+    // the result is added to the queue. lod_debug tints meshes by LOD (green, yellow, orange, red, ...)
+    void draw(const glm::mat4& view_matrix, const glm::mat4& projection_matrix, const FrustumCuller& culler,
+        RenderQueue& queue, RenderStats& stats, bool lod_debug = false);
+
+private:
+    static constexpr uint32_t no_index{ std::numeric_limits<uint32_t>::max() };
+
+    struct Slot {
+        uint32_t dense{ no_index }; // index in the arrays, no_index = free
+        uint32_t generation{ 0 };
+    };
+
+    // origin relative to the parent, source of the local matrix
+    struct Placement {
+        glm::vec3 position{ 0.0f };
+        glm::vec3 eulerAngles{ 0.0f };
+        glm::vec3 scale{ 1.0f };
+    };
+
+    uint32_t dense_index(Id id) const;
+    void update_transform(uint32_t dense);
+    // destroys the object and its subtree, the parent's child list is not touched
+    void destroy_subtree(Id id);
+
+    // slot table and free list
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> free_slots_;
+
+    // dense arrays, all of the same size
+    std::vector<Id> ids_;
+    std::vector<Id> parent_;
+    std::vector<std::vector<Id>> children_;
+    std::vector<TransformSystem::Handle> transform_;
+    std::vector<uint32_t> mesh_;          // in meshes_, no_index = no geometry
+    std::vector<uint32_t> shader_;        // in shaders_
+    std::vector<AABB> bounds_;            // of the mesh, copied for level of detail selection
+    std::vector<BoundingSphere> sphere_;  // of the mesh, copied for culling
+    std::vector<float> world_radius_;     // set by cull()
+    std::vector<uint32_t> cull_index_;    // set by cull()
+    std::vector<uint32_t> lod_;           // level of detail used in the last frame
+    std::vector<Placement> placement_;
+    std::vector<std::string> name_;
+
+    std::unordered_map<std::string, Id> names_;
+
+    // meshes and shaders referenced by objects, with the count of objects and free entries
+    std::vector<std::shared_ptr<Mesh>> meshes_;
+    std::vector<std::shared_ptr<ShaderProgram>> shaders_;
+    std::vector<uint32_t> mesh_refs_;
+    std::vector<uint32_t> shader_refs_;
+    std::vector<uint32_t> free_meshes_;
+    std::vector<uint32_t> free_shaders_;
+    std::unordered_map<const Mesh*, uint32_t> mesh_index_;
+    std::unordered_map<const ShaderProgram*, uint32_t> shader_index_;
+
+    TransformSystem transforms_;
+    std::vector<Mesh::DrawRange> ranges_; // draw() scratch buffer
+};
@@ -1,14 +1,64 @@
 #pragma once
 
+#include <chrono>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <filesystem>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 #include <GL/glew.h> 
 #include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
 
 #include "NonCopyable.hpp"
 
+// Resolved uniform of a program, setting it is a single glProgramUniform*() call.
+// Default (or resolved from an absent name) handle is invalid and set() does nothing.
+// The handle refers to the ShaderProgram's slots, so it stays valid after hot reload
+// and must not outlive the program.
+template <typename T>
+class UniformHandle {
+public:
+    UniformHandle() = default;
+    UniformHandle(const GLuint* program, const GLint* location) : program_{ program }, location_{ location } {}
+
+    bool valid() const { return location_ && *location_ != -1; }
+
+    void set(const T& val) const {
+        if (!valid())
+            return;
+        GLuint program = *program_;
+        GLint location = *location_;
+        if constexpr (std::is_same_v<T, GLfloat>)
+            glProgramUniform1f(program, location, val);
+        else if constexpr (std::is_same_v<T, GLint>)
+            glProgramUniform1i(program, location, val);
+        else if constexpr (std::is_same_v<T, glm::vec3>)
+            glProgramUniform3fv(program, location, 1, glm::value_ptr(val));
+        else if constexpr (std::is_same_v<T, glm::vec4>)
+            glProgramUniform4fv(program, location, 1, glm::value_ptr(val));
+        else if constexpr (std::is_same_v<T, glm::mat3>)
+            glProgramUniformMatrix3fv(program, location, 1, GL_FALSE, glm::value_ptr(val));
+        else if constexpr (std::is_same_v<T, glm::mat4>)
+            glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, glm::value_ptr(val));
+        else
+            static_assert(sizeof(T) == 0, "unsupported uniform type");
+    }
+
+private:
+    const GLuint* program_{ nullptr };
+    const GLint* location_{ nullptr };
+};
+
+// Compilation and linking only start in the constructor, so that many programs compile concurrently
+// (GL_KHR_parallel_shader_compile). Status is checked when the program is first needed (use(), getID(),
+// uniforms); errors are thrown from there.
 class ShaderProgram : private NonCopyable {
 public:
     // No default constructor.  
@@ -17,9 +67,13 @@ public:
     // Constructors for loading shader from string / file
     ShaderProgram(std::string const& vertex_shader_code, std::string const& fragment_shader_code);
     ShaderProgram(std::filesystem::path const& VS_file, std::filesystem::path const& FS_file);
+    // compute shader program
+    explicit ShaderProgram(std::filesystem::path const& CS_file);
 
     // activate shader
     void use(void) {
+        if (pending_)
+            finish_pending();
         if (ID == currently_used_ID) 
             return;
         else {
@@ -34,15 +88,30 @@ public:
         currently_used_ID = 0;
     };
 
-    ~ShaderProgram(void) {  //deallocate shader program
-        deactivate();
-        glDeleteProgram(ID);
-        ID = 0;
-    }
+    ~ShaderProgram(void);
+
+    // true when linking finished, i.e. use() will not wait for the driver
+    bool isReady(void) const;
+
+    // Hot reload of programs loaded from files: checks file times (at most every SHADER_HOT_RELOAD_INTERVAL),
+    // changed sources are compiled in background. Call every frame; returns true when the new program replaced
+    // the current one. On errors the current program stays.
+    bool hotReload(void);
 
-    GLuint getID(void) { return ID; }
+    GLuint getID(void) {
+        if (pending_)
+            finish_pending();
+        return ID;
+    }
     GLint  getAttribLocation(const std::string& name);
 
+    // Resolve uniform once, keep the handle and set it every frame. Absent (or optimized out)
+    // uniforms give invalid handle, the warning is printed only once per name.
+    template <typename T>
+    UniformHandle<T> getUniform(std::string_view name) {
+        return UniformHandle<T>(&ID, uniform_slot(name));
+    }
+
     // set uniform according to name 
     // https://docs.gl/gl4/glUniform
     void setUniform(const std::string& name, const GLfloat val);
@@ -59,15 +128,63 @@ public:
 private:
     GLuint ID{ 0 }; // default = 0, empty shader
     inline static GLuint currently_used_ID{ 0 };
-    std::unordered_map<std::string, GLuint> uniform_location_cache;
+    // heterogeneous lookup, string_view does not allocate
+    struct string_hash {
+        using is_transparent = void;
+        size_t operator()(std::string_view name) const { return std::hash<std::string_view>{}(name); }
+    };
+    // All active uniforms after linking, absent names are added with -1 when first asked for.
+    // Values are updated in place on reload (node based map, UniformHandle keeps pointers).
+    std::unordered_map<std::string, GLint, string_hash, std::equal_to<>> uniform_location_cache;
+
+    // program being compiled and linked, status not checked yet
+    struct Pending {
+        GLuint program{ 0 };
+        std::vector<GLuint> shaders;
+        uint64_t cache_key{ 0 };
+        bool from_cache{ false };
+        std::chrono::steady_clock::time_point start;
+    };
+    std::optional<Pending> pending_;  // initial program
+    std::optional<Pending> reload_;   // replacement by hotReload()
+
+    struct Stage {
+        GLenum type;
+        std::string source_code;
+    };
+
+    // source files for hot reload
+    struct SourceFile {
+        GLenum type;
+        std::filesystem::path path;
+        std::filesystem::file_time_type time{};
+    };
+    std::vector<SourceFile> files_;
+    std::chrono::steady_clock::time_point last_reload_check_{ std::chrono::steady_clock::now() };
 
-    GLuint getUniformLocation(const std::string& name);
+    explicit ShaderProgram(std::vector<SourceFile> files);
+    std::vector<Stage> read_stages(void);
+    std::string file_names(void) const;
+
+    Pending start(std::vector<Stage> stages); // binding defines of Config.hpp are added to the sources
+    bool finish(Pending& pending);     // waits, false on errors (program deleted)
+    void finish_pending(void);
+    static bool is_complete(GLuint program);
+
+    GLint* uniform_slot(std::string_view name);
+    GLint getUniformLocation(std::string_view name) { return *uniform_slot(name); }
+    void cache_uniform_locations(void);
 
     std::string read_text_file(const std::filesystem::path& filename); // load text file
 
+    // on-disk cache of linked programs, see SHADER_CACHE_DIRECTORY
+    static uint64_t program_cache_key(const std::vector<Stage>& stages);
+    GLuint load_program_binary(uint64_t key);
+    void save_program_binary(GLuint program, uint64_t key);
+
     GLuint compile_shader(const std::string& source_code, const GLenum type);
     std::string getShaderInfoLog(const GLuint obj);
 
-    GLuint link_shader(const std::vector<GLuint> shader_ids);
+    GLuint link_shader(const std::vector<GLuint>& shader_ids);
     std::string getProgramInfoLog(const GLuint obj);
 };
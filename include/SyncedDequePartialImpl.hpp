@@ -1,3 +1,5 @@
+#pragma once
+
     #include <deque>
     #include <mutex>              // std::mutex, std::unique_lock
     #include <condition_variable> // std::condition_variable
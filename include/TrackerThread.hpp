@@ -6,8 +6,9 @@
 
 
 
-void tracker_thread_func(cv::VideoCapture& capture,
-    std::atomic<bool>& tracker_terminate,
+// One frame: read, find faces, push both to the deques. Returns false when no more frames can be read.
+bool tracker_step(cv::VideoCapture& capture,
+    cv::CascadeClassifier& face_cascade,
     std::atomic<bool>& tracker_buffer_empty,
     synced_deque<cv::Mat>& frames_deque,
     synced_deque<std::vector<cv::Point2f>>& points_deque);
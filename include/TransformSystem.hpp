@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "NonCopyable.hpp"
+
+// Transform hierarchy: local and world matrices in contiguous arrays (structure of arrays), parent links
+// and dirty flags. update() recomputes only the changed nodes and their subtrees (parents before children),
+// and returns immediately when nothing changed. world = parent world * local.
+class TransformSystem : private NonCopyable
+{
+public:
+    using Handle = uint32_t;
+    static constexpr Handle none{ std::numeric_limits<Handle>::max() };
+
+    TransformSystem() = default;
+
+    // identity local transform
+    Handle create(Handle parent = none);
+    // children must be released (or reparented) first
+    void release(Handle node);
+
+    void setParent(Handle node, Handle parent);
+    void setLocal(Handle node, const glm::mat4& local);
+
+    const glm::mat4& getLocal(Handle node) const { return local_[node]; }
+    // valid after update()
+    const glm::mat4& getWorld(Handle node) const { return world_[node]; }
+
+    // once per frame, before world matrices are read
+    void update();
+
+    // nodes recomputed by the last update()
+    size_t getUpdatedCount() const { return updated_count_; }
+    size_t size() const { return local_.size() - free_.size(); }
+
+private:
+    void rebuild_order();
+
+    std::vector<glm::mat4> local_;
+    std::vector<glm::mat4> world_;
+    std::vector<Handle> parent_;
+    std::vector<uint8_t> dirty_;    // local changed since the last update
+    std::vector<uint8_t> changed_;  // world recomputed in the current update (scratch)
+    std::vector<Handle> free_;
+
+    std::vector<Handle> order_;     // alive nodes, every parent before its children
+    bool order_valid_{ true };
+    bool any_dirty_{ false };
+    size_t updated_count_{ 0 };
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "Assets.hpp"
+#include "Config.hpp"
+
+// vertex layout on GPU, data are always passed as Vertex and converted on upload
+enum class VertexFormat {
+    full,    // Vertex, 32 B
+    compact  // CompactVertex, 16 B; positions are decoded by Mesh::getDecodeMatrix(), which must be part of the model matrix
+};
+constexpr VertexFormat default_vertex_format{ MESH_COMPACT_VERTICES ? VertexFormat::compact : VertexFormat::full };
+
+// attribute slots forced in all shaders
+constexpr GLuint vertex_attribute_position{ 0 };
+constexpr GLuint vertex_attribute_normal{ 1 };
+constexpr GLuint vertex_attribute_texture_coords{ 2 };
+
+inline size_t vertexSize(VertexFormat format) {
+    return format == VertexFormat::full ? sizeof(Vertex) : sizeof(CompactVertex);
+}
+
+// attribute formats of the vertex array, all attributes read from buffer binding 0
+inline void setupVertexAttributes(GLuint vao, VertexFormat format) {
+    if (format == VertexFormat::full) {
+        glVertexArrayAttribFormat(vao, vertex_attribute_position, glm::vec3::length(), GL_FLOAT, GL_FALSE, offsetof(Vertex, position));
+        glVertexArrayAttribFormat(vao, vertex_attribute_normal, glm::vec3::length(), GL_FLOAT, GL_FALSE, offsetof(Vertex, normal));
+        glVertexArrayAttribFormat(vao, vertex_attribute_texture_coords, glm::vec2::length(), GL_FLOAT, GL_FALSE, offsetof(Vertex, texCoords));
+    }
+    else {
+        glVertexArrayAttribFormat(vao, vertex_attribute_position, 3, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(CompactVertex, position));
+        glVertexArrayAttribFormat(vao, vertex_attribute_normal, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offsetof(CompactVertex, normal));
+        glVertexArrayAttribFormat(vao, vertex_attribute_texture_coords, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(CompactVertex, texCoords));
+    }
+
+    for (GLuint location : { vertex_attribute_position, vertex_attribute_normal, vertex_attribute_texture_coords }) {
+        glVertexArrayAttribBinding(vao, location, 0);
+        glEnableVertexArrayAttrib(vao, location);
+    }
+}
@@ -1,6 +1,18 @@
 #version 460 core
 out vec4 FragColor;
-uniform vec4 my_color;
+
+// frame-global data, must match FrameUniforms::Data
+layout(std140, binding = FRAME_UNIFORMS_BINDING) uniform FrameUniforms {
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uViewProjection;
+    vec4 uCameraPosition;
+    vec4 uColor;
+    float uTime;
+    float uDeltaTime;
+};
+
+flat in vec4 vTint;
 void main() {
-    FragColor = my_color;//vec4(1.0, 0.5, 0.2, 1.0); // orange
+    FragColor = uColor * vTint;//vec4(1.0, 0.5, 0.2, 1.0); // orange
 }
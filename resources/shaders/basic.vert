@@ -1,10 +1,31 @@
 #version 460 core
 layout(location = 0) in vec3 aPos;
 
-uniform mat4 uP_m = mat4(1.0);
-uniform mat4 uM_m = mat4(1.0);
-uniform mat4 uV_m = mat4(1.0);
+// per-draw data of RenderQueue, indexed by base instance of the indirect command
+struct DrawData {
+    mat4 model;
+    vec4 tint;
+};
+layout(std430, binding = MULTIDRAW_DRAW_DATA_BINDING) readonly buffer DrawDataBuffer {
+    DrawData draws[];
+};
+
+// frame-global data, must match FrameUniforms::Data
+layout(std140, binding = FRAME_UNIFORMS_BINDING) uniform FrameUniforms {
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uViewProjection;
+    vec4 uCameraPosition;
+    vec4 uColor;
+    float uTime;
+    float uDeltaTime;
+};
+
+
+flat out vec4 vTint;
 
 void main() {
-    gl_Position = uP_m * uV_m * uM_m * vec4(aPos, 1.0f);
-}
\ No newline at end of file
+    DrawData draw = draws[gl_BaseInstance];
+    vTint = draw.tint;
+    gl_Position = uViewProjection * draw.model * vec4(aPos, 1.0f);
+}
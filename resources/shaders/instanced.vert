@@ -0,0 +1,32 @@
+#version 460 core
+layout(location = 0) in vec3 aPos;
+
+// per-instance data of InstancedModel
+struct Instance {
+    mat4 model;
+    vec4 color;
+};
+layout(std430, binding = INSTANCE_DATA_BINDING) readonly buffer InstanceBuffer {
+    Instance instances[];
+};
+
+// frame-global data, must match FrameUniforms::Data
+layout(std140, binding = FRAME_UNIFORMS_BINDING) uniform FrameUniforms {
+    mat4 uView;
+    mat4 uProjection;
+    mat4 uViewProjection;
+    vec4 uCameraPosition;
+    vec4 uColor;
+    float uTime;
+    float uDeltaTime;
+};
+
+uniform mat4 uDecode_m = mat4(1.0);
+
+flat out vec4 vTint;
+
+void main() {
+    Instance instance = instances[gl_InstanceID];
+    vTint = instance.color;
+    gl_Position = uViewProjection * instance.model * uDecode_m * vec4(aPos, 1.0f);
+}
@@ -1,13 +1,18 @@
 #include <iostream>
+#include <chrono>
+#include <cstdlib>
 #include <numeric>
-#include <execution>
+#include <random>
+#include <thread>
 
 #include <opencv2/core/types.hpp>
 #include <nlohmann/json.hpp>
 
 // OpenGL headers
 #include <GL/glew.h>
+#ifdef _WIN32
 #include <GL/wglew.h>
+#endif
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
@@ -22,6 +27,7 @@
 
 #include "App.hpp"
 #include "ObjectLoader.hpp"
+#include "MeshCache.hpp"
 
 App::App()
 {
@@ -40,18 +46,51 @@ void App::init_opencv()
     {
         std::cout << "Camera opened successfully.\n";
     }
+
+    face_cascade = cv::CascadeClassifier("../resources/haarcascade_frontalface_default.xml");
+}
+
+void App::tracker_job()
+{
+    // destroy() waits for tracker_done, it must be set on every way out
+    bool next_frame = false;
+    try {
+        next_frame = !tracker_terminate && tracker_step(capture, face_cascade, tracker_buffer_empty, tracker_frame_deque, tracker_pos_deque);
+        if (next_frame)
+            job_system.submitBackground([this]() { tracker_job(); });
+    }
+    catch (std::exception const& e) {
+        std::cerr << "Tracker failed: " << e.what() << '\n';
+        next_frame = false;
+    }
+    catch (...) {
+        std::cerr << "Tracker failed: unknown exception\n";
+        next_frame = false;
+    }
+    if (!next_frame)
+        tracker_done = true;
 }
 
 void App::init_glfw()
 {
     glfwSetErrorCallback(glfw_error_callback);
 
+#if defined(GLFW_PLATFORM_NULL) && !defined(_WIN32)
+    // no display server (CI, render nodes): context without window system
+    if (headless.enabled && !std::getenv("DISPLAY") && !std::getenv("WAYLAND_DISPLAY"))
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+
     if (!glfwInit())
         throw std::runtime_error("GLFW init failed!");
 
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#if defined(GLFW_PLATFORM_NULL) && !defined(_WIN32)
+    if (glfwGetPlatform() == GLFW_PLATFORM_NULL)
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API); // surfaceless, e.g. Mesa llvmpipe
+#endif
     
     glfwWindowHint(GLFW_SAMPLES, 4);
 
@@ -77,17 +116,24 @@ void App::init_glfw()
 
 void App::init_glew()
 {
+#ifdef _WIN32
     GLenum glew_retval = glewInit();
+#else
+    // GLX extensions need an X display, which headless contexts do not have
+    GLenum glew_retval = headless.enabled ? glewContextInit() : glewInit();
+#endif
     if (glew_retval != GLEW_OK)
         throw std::runtime_error(std::string("GLEW init failed!") + (const char*)glewGetErrorString(glew_retval));
     else
         std::cout << "GLEW version: " << glewGetString(GLEW_VERSION) << '\n';
 
+#ifdef _WIN32
     GLenum wglew_retval = wglewInit();
     if (wglew_retval != GLEW_OK)
         throw std::runtime_error(std::string("WGLEW init failed!") + (const char*)glewGetErrorString(wglew_retval));
     else
         std::cout << "WGLEW initialized" << '\n';
+#endif
 
     if (!GLEW_ARB_direct_state_access)
     {
@@ -108,6 +154,18 @@ void App::init_glew()
     else
         std::cout << "GL_DEBUG NOT SUPPORTED!" << std::endl;
 
+    // shaders of the library are compiled concurrently by driver threads
+    if (GLEW_KHR_parallel_shader_compile)
+    {
+        glMaxShaderCompilerThreadsKHR(SHADER_COMPILER_THREADS);
+        std::cout << "Parallel shader compilation enabled." << std::endl;
+    }
+    else if (GLEW_ARB_parallel_shader_compile)
+    {
+        glMaxShaderCompilerThreadsARB(SHADER_COMPILER_THREADS);
+        std::cout << "Parallel shader compilation enabled." << std::endl;
+    }
+
     if (GLEW_ARB_multisample)
     {
         std::cout << "GL antialiasing is supported." << std::endl;
@@ -200,47 +258,133 @@ void App::print_gl_info()
     }
 }
 
-void App::init_assets(void) {
+void App::load_model(const std::string& name, const std::filesystem::path& filename, std::shared_ptr<ShaderProgram> shader) {
+    if (!std::filesystem::exists(filename)) {
+        throw std::runtime_error("File does not exist: " + filename.string());
+    }
 
-    // load shaders from file to shader_library 
-    shader_library.emplace("simple_shader", std::make_shared<ShaderProgram>(std::filesystem::path("../resources/shaders/basic.vert"), std::filesystem::path("../resources/shaders/basic.frag")));
- 
-    // Load mesh
-    std::filesystem::path filename = "../resources/models/triangle.obj";
+    // empty model draws nothing until all its meshes are on GPU
+    Scene::Id model = scene.create(name);
+
+    // parsed (or read from binary cache) in background, uploaded by parts in the frame loop;
+    // every OBJ object/group/material is a separate mesh with its own bounds
+    asset_streamer.request(filename, [this, model, name, shader](std::vector<AssetStreamer::StreamedMesh>& meshes) {
+        for (auto& streamed : meshes) {
+            mesh_library.emplace(name + '/' + streamed.name, streamed.mesh);
+            // the model may have been removed meanwhile
+            if (scene.contains(model))
+                scene.addMesh(model, streamed.mesh, shader);
+        }
+        });
+}
+
+void App::load_instanced_model(const std::string& name, const std::filesystem::path& filename, std::shared_ptr<ShaderProgram> shader) {
     if (!std::filesystem::exists(filename)) {
         throw std::runtime_error("File does not exist: " + filename.string());
     }
 
-    std::vector<Vertex> vertices;
-    std::vector<GLuint> indices;
-    if (!loadOBJ(filename, vertices, indices)) {
-        throw std::runtime_error("Loading failed: " + filename.string());
+    // instances can be placed right away, they are drawn once the meshes are on GPU
+    instanced_scene.try_emplace(name);
+    asset_streamer.request(filename, [this, name, shader](std::vector<AssetStreamer::StreamedMesh>& meshes) {
+        auto& model = instanced_scene.at(name);
+        for (auto& streamed : meshes) {
+            mesh_library.emplace(name + '/' + streamed.name, streamed.mesh);
+            model.addMesh(streamed.mesh, shader);
+        }
+        });
+}
+
+void App::init_assets(void) {
+    auto assets_start = std::chrono::steady_clock::now();
+
+    // shared vertex and index buffers for all streamed meshes
+    geometry_arena = std::make_shared<GeometryArena>();
+    asset_streamer.setGeometryArena(geometry_arena);
+
+    // load shaders from file to shader_library (compiled in parallel, checked at first use)
+    shader_library.emplace("simple_shader", std::make_shared<ShaderProgram>(std::filesystem::path("../resources/shaders/basic.vert"), std::filesystem::path("../resources/shaders/basic.frag")));
+    shader_library.emplace("instanced_shader", std::make_shared<ShaderProgram>(std::filesystem::path("../resources/shaders/instanced.vert"), std::filesystem::path("../resources/shaders/basic.frag")));
+    shader_library.emplace("hiz_shader", std::make_shared<ShaderProgram>(std::filesystem::path("../resources/shaders/hiz.comp")));
+    hiz_buffer = std::make_unique<HiZBuffer>(shader_library.at("hiz_shader"));
+ 
+    if (benchmark) {
+        // culling results must not depend on GPU timing
+        hiz_buffer->setWaitForResults(true);
+        init_benchmark_scene();
+        return;
     }
 
-    auto mesh = std::make_shared<Mesh>(vertices, indices, GL_TRIANGLES);
+    // Load models (asynchronously, init does not wait for them)
+    load_model("simple_object", "../resources/models/triangle.obj", shader_library.at("simple_shader"));
+    load_model("bunny", "../resources/models/bunny_tri_vnt.obj", shader_library.at("simple_shader"));
+    load_model("man", "../resources/models/man.obj", shader_library.at("simple_shader"));
+    scene.setPosition(scene.find("man"), glm::vec3(5.0f, 0.0f, 0.0f));
 
-    auto mesh_ptr = std::make_shared<Mesh>(vertices, indices, GL_TRIANGLES);
-    mesh_library.emplace("simple_mesh", mesh_ptr);
+    if (INSTANCED_FOREST)
+        plant_forest("forest", INSTANCED_TREE_COUNT);
 
-    // Load model and attach mesh
-    Model my_model;
-    my_model.addMesh(mesh_ptr, shader_library.at("simple_shader"));
-    scene.emplace("simple_object", my_model);
+    std::chrono::duration<double, std::milli> assets_time = std::chrono::steady_clock::now() - assets_start;
+    std::cout << "Assets initialized in " << assets_time.count() << " ms (models are streamed in background)\n";
+}
 
-    std::vector<Vertex> vertices2;
-    std::vector<GLuint> indices2;
-    filename = "../resources/models/bunny_tri_vnt.obj";
-    if (!loadOBJ(filename, vertices2, indices2)) {
-        throw std::runtime_error("Loading failed: " + filename.string());
+glm::vec3 App::plant_forest(const std::string& name, int count)
+{
+    // square grid behind the scene, random (but the same every run) rotation, size and shade of each tree
+    load_instanced_model(name, "../resources/models/Lowpoly_tree_sample.obj", shader_library.at("instanced_shader"));
+    auto& forest = instanced_scene.at(name);
+    std::mt19937 random(0);
+    std::uniform_real_distribution<float> angle(0.0f, 360.0f), size(0.7f, 1.3f), shade(0.6f, 1.0f), jitter(-0.3f, 0.3f);
+    int side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(count))));
+    for (int i = 0; i < count; i++) {
+        // drawn one by one, evaluation order of arguments is not specified
+        float jitter_x = jitter(random);
+        float jitter_z = jitter(random);
+        float rotation = angle(random);
+        float scale = size(random);
+        float green = shade(random);
+        glm::vec3 position((i % side - side / 2 + jitter_x) * INSTANCED_TREE_SPACING, -1.0f, -(i / side + 2 + jitter_z) * INSTANCED_TREE_SPACING);
+        glm::mat4 model_matrix = glm::translate(glm::mat4(1.0f), position);
+        model_matrix = glm::rotate(model_matrix, glm::radians(rotation), glm::vec3(0.0f, 1.0f, 0.0f));
+        model_matrix = glm::scale(model_matrix, glm::vec3(INSTANCED_TREE_SCALE * scale));
+        forest.addInstance(model_matrix, glm::vec4(0.3f * green, green, 0.3f * green, 1.0f));
     }
-   
-    auto mesh2 = std::make_shared<Mesh>(vertices2, indices2, GL_TRIANGLES);
-    mesh_library.emplace("bunny_mesh", mesh_ptr);
+    return glm::vec3(0.0f, -1.0f, -(side / 2 + 2) * INSTANCED_TREE_SPACING);
+}
 
-    Model model2;
-    my_model.addMesh(mesh2, shader_library.at("simple_shader"));
-    scene.emplace("bunny", my_model);
+void App::init_benchmark_scene()
+{
+    int count = static_cast<int>(benchmark->count);
+    int side = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(std::max(count, 1)))));
+
+    if (benchmark->scene == "bunnies") {
+        // separate objects sharing one streamed model, stress the scene, culling and the render queue
+        std::vector<Scene::Id> bunnies;
+        for (int i = 0; i < count; i++) {
+            Scene::Id bunny = scene.create("bunny_" + std::to_string(i));
+            scene.setPosition(bunny, glm::vec3((i % side - side / 2) * BENCHMARK_SPACING, 0.0f, (i / side - side / 2) * BENCHMARK_SPACING));
+            bunnies.push_back(bunny);
+        }
+        auto shader = shader_library.at("simple_shader");
+        asset_streamer.request("../resources/models/bunny_tri_vnt.obj", [this, bunnies, shader](std::vector<AssetStreamer::StreamedMesh>& meshes) {
+            for (auto& streamed : meshes) {
+                mesh_library.emplace("bunny/" + streamed.name, streamed.mesh);
+                for (Scene::Id bunny : bunnies)
+                    scene.addMesh(bunny, streamed.mesh, shader);
+            }
+            });
+        // around the whole grid, looking down at it
+        float extent = side * BENCHMARK_SPACING;
+        benchmark_path = BenchmarkPath{ glm::vec3(0.0f), extent * 0.75f, extent * 0.25f };
+    }
+    else if (benchmark->scene == "trees") {
+        // through the forest at eye level, most trees are hidden by the nearer ones
+        glm::vec3 center = plant_forest("forest", count);
+        benchmark_path = BenchmarkPath{ center, side * INSTANCED_TREE_SPACING * 0.35f, 2.5f };
+    }
+    else
+        throw std::runtime_error("Unknown benchmark scene: " + benchmark->scene);
 
+    std::cout << "Benchmark scene: " << count << ' ' << benchmark->scene << '\n';
 }
 
 void App::init_imgui()
@@ -252,8 +396,45 @@ void App::init_imgui()
     std::cout << "ImGUI version: " << ImGui::GetVersion() << "\n";
 }
 
-bool App::init()
+void App::init_offscreen()
 {
+    if (headless.width <= 0 || headless.height <= 0)
+        throw std::runtime_error("Invalid headless resolution!");
+
+    glCreateRenderbuffers(1, &offscreen_color);
+    glNamedRenderbufferStorage(offscreen_color, GL_RGBA8, headless.width, headless.height);
+    glCreateRenderbuffers(1, &offscreen_depth);
+    glNamedRenderbufferStorage(offscreen_depth, GL_DEPTH24_STENCIL8, headless.width, headless.height);
+
+    glCreateFramebuffers(1, &offscreen_framebuffer);
+    glNamedFramebufferRenderbuffer(offscreen_framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreen_color);
+    glNamedFramebufferRenderbuffer(offscreen_framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, offscreen_depth);
+    if (glCheckNamedFramebufferStatus(offscreen_framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw std::runtime_error("Offscreen framebuffer incomplete!");
+
+    // drawn and read back instead of the window for the whole run
+    glBindFramebuffer(GL_FRAMEBUFFER, offscreen_framebuffer);
+    std::cout << "Headless: " << headless.width << 'x' << headless.height << " offscreen\n";
+}
+
+bool App::init(const HeadlessSettings& headless_settings, const std::optional<BenchmarkSettings>& benchmark_settings)
+{
+    headless = headless_settings;
+    benchmark = benchmark_settings;
+    if (benchmark) {
+        // fixed number of frames, GPU time of every one of them
+        headless.enabled = true;
+        headless.frames = benchmark->warmup_frames + benchmark->frames;
+        benchmark_recorder = BenchmarkRecorder(benchmark->warmup_frames);
+        gpu_profiler.setWaitForResults(true);
+        occlusion_culling = benchmark->occlusion_culling;
+    }
+    if (headless.enabled) {
+        // unattended: no vsync, no GUI overlay in the rendered frames
+        is_vsync_on = false;
+        show_imgui = false;
+    }
+
     try {
         std::cout << "Current working directory: " << std::filesystem::current_path().generic_string() << '\n';
 
@@ -267,7 +448,9 @@ bool App::init()
             std::filesystem::create_directory("../screenshots");
         }
 
-        init_opencv();
+        // camera is not needed (nor present) for offscreen rendering
+        if (!headless.enabled)
+            init_opencv();
 
         init_glfw();
         init_glew();
@@ -285,7 +468,10 @@ bool App::init()
 
         init_imgui();
 
-        glfwShowWindow(window);
+        if (headless.enabled)
+            init_offscreen();
+        else
+            glfwShowWindow(window);
     }
     catch (std::exception const& e) {
         std::cerr << "App init failed : " << e.what() << std::endl;
@@ -308,6 +494,9 @@ int App::run(void)
     glm::vec4 my_rgba(r, g, b, a);
 
     FpsMeter gl_fps_meter(std::chrono::milliseconds(FPS_METER_INTERVAL));
+
+    // view, projection etc. shared by all shaders
+    FrameUniforms frame_uniforms;
     double gl_fps{ 0.0 }; //unintentional surprised face LOL!
 
     std::string fps_string;
@@ -321,16 +510,16 @@ int App::run(void)
     cv::Scalar fps_text_color(0, 255, 0);
     cv::Mat show_frame;
 
-    tracker_thread = std::thread(tracker_thread_func,
-                               std::ref(capture), 
-                               std::ref(tracker_terminate),
-                               std::ref(tracker_buffer_empty),
-                               std::ref(tracker_frame_deque),
-                               std::ref(tracker_pos_deque));
+    // one background job per camera frame (blocks in capture), resubmitted until terminated
+    if (!headless.enabled) {
+        tracker_done = false;
+        job_system.submitBackground([this]() { tracker_job(); });
+    }
 
     double now = glfwGetTime();
     double begin_time = now;
     double last_time = now; // so that delta time is 0 at the beginning
+    double job_stats_time = now;
 
     bool paused_by_tracker = false;
 
@@ -339,7 +528,18 @@ int App::run(void)
     float triangle_animation_speed = 120.0;
     float triangle_hue{};
 
-    glfwGetFramebufferSize(window, &viewport_width, &viewport_height);
+    if (headless.enabled) {
+        viewport_width = headless.width;
+        viewport_height = headless.height;
+
+        // every rendered frame shows the whole scene
+        while (asset_streamer.pending() > 0) {
+            asset_streamer.update();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    else
+        glfwGetFramebufferSize(window, &viewport_width, &viewport_height);
     glViewport(0, 0, viewport_width, viewport_height);
     update_projection_matrix();
     screenshot.create(viewport_height, viewport_width, CV_8UC3);
@@ -347,8 +547,29 @@ int App::run(void)
     //set initial camera position
     //camera.Position = glm::vec3(0, 0, 10);
 
-    while (!glfwWindowShouldClose(window))
+    uint64_t frame_count = 0;
+    uint64_t gpu_frames_recorded = 0;
+    // GPU times come GPU_PROFILER_FRAMES - 1 frames late, none is dropped while benchmarking
+    auto record_gpu_frames = [&]() {
+        for (; gpu_frames_recorded < gpu_profiler.getMeasuredFrames(); gpu_frames_recorded++) {
+            for (const auto& scope : gpu_profiler.getScopes())
+                if (scope.name == "frame")
+                    benchmark_recorder.setGpuTime(gpu_frames_recorded, scope.last_ms);
+        }
+    };
+
+    while (!glfwWindowShouldClose(window) && !(headless.enabled && headless.frames > 0 && frame_count >= headless.frames))
     {
+        // results of previous frames from GPU; while benchmarking these wait for the GPU,
+        // so they are collected before the measured CPU time of the frame starts
+        gpu_profiler.beginFrame();
+        if (benchmark)
+            record_gpu_frames();
+        if (occlusion_culling)
+            hiz_buffer->fetch();
+
+        auto frame_start = std::chrono::steady_clock::now();
+
         // Find face
         if (tracker_buffer_empty) {
             std::cout << "Couldn't get new frame";
@@ -400,18 +621,41 @@ int App::run(void)
             ImGui::NewFrame();
             //ImGui::ShowDemoWindow(); // Enable mouse when using Demo!
             ImGui::SetNextWindowPos(ImVec2(10, 10));
-            ImGui::SetNextWindowSize(ImVec2(250, 100));
 
-            ImGui::Begin("Info", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
+            ImGui::Begin("Info", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove);
             ImGui::Text("V-Sync: %s", is_vsync_on ? "ON" : "OFF");
             ImGui::Text("FPS: %.1f", gl_fps);
+            if (asset_streamer.pending() > 0)
+                ImGui::Text("Loading models: %zu", asset_streamer.pending());
+            // counters of the previous frame
+            ImGui::Text("Meshes: %zu visible / %zu culled / %zu occluded", render_stats.meshes_visible, render_stats.meshes_culled, render_stats.meshes_occluded);
+            ImGui::Text("Triangles: %zu visible / %zu submitted", render_stats.triangles_visible, render_stats.triangles_submitted);
+            ImGui::Text("Meshlets: %zu visible / %zu submitted", render_stats.meshlets_visible, render_stats.meshlets_submitted);
+            ImGui::Text("Draw calls: %zu (%zu commands)", render_stats.draw_calls, render_stats.draw_commands);
+            ImGui::Text("State changes: %zu shaders, %zu vertex arrays", render_stats.shader_changes, render_stats.vertex_array_changes);
+            ImGui::Text("Objects: %zu, transforms updated: %zu", scene.size(), render_stats.transforms_updated);
+            for (size_t i = 0; i < job_stats.size(); i++)
+                ImGui::Text("Worker %zu: %3.0f %% busy, %llu jobs, %llu steals", i, job_stats[i].utilization * 100.0,
+                    static_cast<unsigned long long>(job_stats[i].jobs), static_cast<unsigned long long>(job_stats[i].steals));
+            // smoothed, measured a few frames ago
+            for (const auto& scope : gpu_profiler.getScopes())
+                ImGui::Text("GPU %s: %.3f ms", scope.name.c_str(), scope.average_ms);
+            if (geometry_arena)
+                ImGui::Text("Geometry arena: %.1f / %.1f MB", geometry_arena->usedBytes() / 1048576.0, geometry_arena->capacityBytes() / 1048576.0);
+            ImGui::Checkbox("LOD colors", &show_lod_debug);
+            if (ImGui::Checkbox("Occlusion culling", &occlusion_culling) && !occlusion_culling)
+                hiz_buffer->clear();
+            if (show_lod_debug) {
+                for (const auto& [name, model] : scene.getNames())
+                    ImGui::Text("%s: LOD %u", name.c_str(), scene.getLod(model));
+            }
             ImGui::Text("(press RMB to release mouse)");
             ImGui::Text("(hit D to show/hide info)");
             ImGui::End();
         }
 
         //GAME STATE UPDATES HERE
-        double delta_time = begin_time - last_time;
+        double delta_time = benchmark ? BENCHMARK_TIME_STEP : begin_time - last_time;
         double time_step = game_paused ? 0 : game_speed * delta_time;
 
         triangle_hue += triangle_animation_speed * time_step;
@@ -420,53 +664,116 @@ int App::run(void)
 
         if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS)
         {
-            scene.at("bunny").rotate(glm::vec3(0.0f, 180.0f * time_step, 0.0f));
+            scene.rotate(scene.find("bunny"), glm::vec3(0.0f, 180.0f * time_step, 0.0f));
+        }
+
+        // finish uploads of streamed models, limited time per frame
+        asset_streamer.update();
+
+        // changed shader files are compiled in background, swapped when linked;
+        // not in offline runs, a synchronous recompile would show up in the measured frames
+        if (SHADER_HOT_RELOAD && !headless.enabled && !benchmark) {
+            for (auto& [name, shader] : shader_library)
+                shader->hotReload();
         }
 
+        size_t gpu_frame_scope = gpu_profiler.begin("frame");
+
         // clear canvas
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        {
+            GpuProfiler::Scope scope(gpu_profiler, "clear");
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
 
-        // activate shader
-        auto& current_shader = shader_library.at("simple_shader");
-        current_shader->use();
-        current_shader->setUniform("my_color", my_rgba);
         //set View matrix = set CAMERA
-        camera.ProcessInput(window, delta_time);
+        if (benchmark) {
+            // warm-up frames stay at the start of the path
+            float yaw, pitch;
+            uint64_t path_frame = frame_count > benchmark->warmup_frames ? frame_count - benchmark->warmup_frames : 0;
+            benchmark_path.pose(path_frame, benchmark->frames, camera.Position, yaw, pitch);
+            camera.SetOrientation(yaw, pitch);
+        }
+        else
+            camera.ProcessInput(window, delta_time);
         update_projection_matrix();
         glm::mat4 view_matrix = camera.GetViewMatrix();
-        current_shader->setUniform("uV_m", view_matrix);
-        current_shader->setUniform("uP_m", projection_matrix);
-
-        //draw all models from scene
-        for (auto &model : scene) {
-            model.second.update(now);
-            model.second.draw();
+        glm::mat4 view_projection = projection_matrix * view_matrix;
+
+        // world matrices of moved subtrees only (no work on a static scene), then bounding spheres
+        // of all meshes are culled in one batch; runs as jobs while this thread writes the uniforms
+        // spheres in the frustum are tested against the newest depth read back from previous frames
+        render_stats.reset();
+        const HiZBuffer* occlusion = occlusion_culling ? hiz_buffer.get() : nullptr;
+        auto transform_job = job_system.submit([this]() { scene.update(render_stats); });
+        auto cull_job = job_system.submit([this, view_projection, occlusion]() {
+            frustum_culler.clear();
+            scene.cull(frustum_culler, job_system);
+            frustum_culler.cull(Frustum(view_projection), render_stats, &job_system, occlusion);
+            }, { transform_job });
+
+        // frame-global uniforms, written once for all shaders
+        FrameUniforms::Data frame_data;
+        frame_data.view = view_matrix;
+        frame_data.projection = projection_matrix;
+        frame_data.view_projection = view_projection;
+        frame_data.camera_position = glm::vec4(camera.Position, 1.0f);
+        frame_data.color = my_rgba;
+        frame_data.time = static_cast<float>(benchmark ? frame_count * BENCHMARK_TIME_STEP : now);
+        frame_data.delta_time = static_cast<float>(delta_time);
+        frame_uniforms.update(frame_data);
+
+        //draw all models from scene, visible ones only
+        size_t gpu_scene_scope = gpu_profiler.begin("scene");
+        job_system.wait(cull_job);
+        scene.draw(view_matrix, projection_matrix, frustum_culler, render_queue, render_stats, show_lod_debug);
+        render_queue.submit(render_stats);
+        gpu_profiler.end(gpu_scene_scope);
+
+        // instanced models, one draw call per mesh
+        size_t gpu_instances_scope = gpu_profiler.begin("instances");
+        for (auto& model : instanced_scene)
+            model.second.draw(render_stats);
+        gpu_profiler.end(gpu_instances_scope);
+
+        // depth pyramid of this frame for occlusion culling of the next ones (read back asynchronously)
+        if (occlusion_culling) {
+            GpuProfiler::Scope scope(gpu_profiler, "hi-z");
+            hiz_buffer->build(offscreen_framebuffer, viewport_width, viewport_height, view_projection);
         }
 
         if (show_imgui) {
+            GpuProfiler::Scope scope(gpu_profiler, "imgui");
             ImGui::Render();
             ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         }
 
         if (glfwGetKey(window, GLFW_KEY_F10) == GLFW_PRESS)
-        {
-            glReadPixels(0, 0, screenshot.cols, screenshot.rows, GL_BGR, GL_UNSIGNED_BYTE, screenshot.data);
-            cv::flip(screenshot, screenshot, 0);
-            auto screenshot_now = std::chrono::system_clock::now();
-            auto screenshot_time_t = std::chrono::system_clock::to_time_t(screenshot_now);
-            std::stringstream filename;
-            filename << "../screenshots/" + std::string(SCREENSHOT_FILE_NAME) + '_';
-            filename << std::put_time(std::localtime(&screenshot_time_t), SCREENSHOT_TIMESTAMP_FORMAT);
-            filename << ".jpg";
-            cv::imwrite(filename.str().c_str(), screenshot);
+            save_screenshot();
+
+        gpu_profiler.end(gpu_frame_scope);
+        gpu_profiler.endFrame();
+        frame_uniforms.endFrame();
+
+        if (headless.enabled)
+            glFlush(); // nothing to present, the frame stays in the offscreen framebuffer
+        else
+            glfwSwapBuffers(window);
+        if (benchmark) {
+            std::chrono::duration<double, std::milli> frame_time = std::chrono::steady_clock::now() - frame_start;
+            benchmark_recorder.addFrame(frame_time.count(), render_stats);
         }
-
-        glfwSwapBuffers(window);
+        frame_count++;
 
         now = glfwGetTime();
         last_time = begin_time;
         begin_time = now;
 
+        // worker utilization for the info window
+        if (now - job_stats_time >= JOB_STATS_INTERVAL) {
+            job_stats = job_system.sampleStats();
+            job_stats_time = now;
+        }
+
         gl_fps_meter.update();
         if (gl_fps_meter.is_updated())
         {
@@ -476,26 +783,67 @@ int App::run(void)
             std::string title_string = std::string(WINDOW_TITLE) + " [" + (game_paused ? "Paused, " : "") + 
                 "FPS: " + ss.str() + ", VSync: " + (is_vsync_on ? "ON" : "OFF") + "]";
             glfwSetWindowTitle(window, title_string.c_str());
+            if (headless.enabled)
+                std::cout << "Headless: frame " << frame_count << ", FPS: " << ss.str() << '\n';
         }
 
         // poll events, call callbacks, flip back<->front buffer
         glfwPollEvents();
     }
+
+    if (benchmark) {
+        // results of the last frames still in flight
+        for (size_t i = 0; i < GPU_PROFILER_FRAMES; i++) {
+            gpu_profiler.beginFrame();
+            gpu_profiler.endFrame();
+        }
+        record_gpu_frames();
+
+        nlohmann::ordered_json info;
+        info["scene"] = benchmark->scene;
+        info["objects"] = benchmark->count;
+        info["resolution"] = { viewport_width, viewport_height };
+        info["warmup_frames"] = benchmark->warmup_frames;
+        info["occlusion_culling"] = occlusion_culling;
+        info["renderer"] = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+        return benchmark_recorder.write(benchmark->output, info) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // result of offline rendering
+    if (headless.enabled)
+        save_screenshot();
     return EXIT_SUCCESS;
 }
 
-void App::destroy(void)
+void App::save_screenshot(void)
 {
-    // Terminate tracker
-    if (tracker_thread.joinable())
     {
-        tracker_terminate = true;
-        tracker_thread.join();
+        GpuProfiler::Scope scope(gpu_profiler, "screenshot");
+        // rows of the Mat are tightly packed, GL would pad them to 4 bytes by default
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, screenshot.cols, screenshot.rows, GL_BGR, GL_UNSIGNED_BYTE, screenshot.data);
+    }
+    cv::flip(screenshot, screenshot, 0);
+    auto screenshot_now = std::chrono::system_clock::now();
+    auto screenshot_time_t = std::chrono::system_clock::to_time_t(screenshot_now);
+    std::stringstream filename;
+    filename << "../screenshots/" + std::string(SCREENSHOT_FILE_NAME) + '_';
+    filename << std::put_time(std::localtime(&screenshot_time_t), SCREENSHOT_TIMESTAMP_FORMAT);
+    filename << ".jpg";
+    cv::imwrite(filename.str().c_str(), screenshot);
+}
+
+void App::destroy(void)
+{
+    // Terminate tracker, helps with other jobs meanwhile
+    tracker_terminate = true;
+    job_system.waitUntil([this]() { return tracker_done.load(); });
+    // clean up ImGUI, if init() got that far
+    if (ImGui::GetCurrentContext()) {
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
     }
-    // clean up ImGUI
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
 
     // OpenGL clean-up
     if (shader_prog_ID)
@@ -504,6 +852,12 @@ void App::destroy(void)
         glDeleteBuffers(1, &VBO_ID);
     if (VAO_ID)
         glDeleteVertexArrays(1, &VAO_ID);
+    if (offscreen_framebuffer)
+        glDeleteFramebuffers(1, &offscreen_framebuffer);
+    if (offscreen_color)
+        glDeleteRenderbuffers(1, &offscreen_color);
+    if (offscreen_depth)
+        glDeleteRenderbuffers(1, &offscreen_depth);
 
     // clean-up OpenCV
     cv::destroyAllWindows();
@@ -623,8 +977,13 @@ cv::Point2f App::find_object_chroma(cv::Mat & frame)
     // You need at least C++17 for std::reduce()
     //cv::Point2f whiteAccum = std::reduce(whitePixels.begin(), whitePixels.end());
 
-    // or faster = parallel version, with automatic multi-threading
-    cv::Point2f whiteAccum = std::reduce(std::execution::par_unseq, whitePixels.begin(), whitePixels.end());
+    // or faster = parallel version, partial sums of chunks computed by jobs
+    size_t grain = JOB_GRAIN_SIZE * 16;
+    std::vector<cv::Point> partial((whitePixels.size() + grain - 1) / grain);
+    job_system.parallelFor(whitePixels.size(), grain, [&](size_t begin, size_t end) {
+        partial[begin / grain] = std::reduce(whitePixels.begin() + begin, whitePixels.begin() + end);
+        });
+    cv::Point2f whiteAccum = std::reduce(partial.begin(), partial.end());
 
     // Divide by whiteCnt to get average, ie. centroid (only if whiteCnt != 0 !!!)
     cv::Point2f centroid_absolute = whiteAccum / whiteCnt;
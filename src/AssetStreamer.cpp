@@ -0,0 +1,122 @@
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+#include "AssetStreamer.hpp"
+
+AssetStreamer::AssetStreamer(JobSystem& jobs)
+    : jobs_(jobs)
+{
+}
+
+AssetStreamer::~AssetStreamer()
+{
+    // jobs refer to this object
+    for (const auto& job : parse_jobs_)
+        jobs_.wait(job);
+}
+
+void AssetStreamer::request(const std::filesystem::path& filename, ReadyCallback on_ready)
+{
+    pending_++;
+    // background queue, the GL thread never runs parsing while it waits for frame jobs
+    parse_jobs_.push_back(jobs_.submitBackground([this, request = Request{ filename, std::move(on_ready) }]() mutable {
+        parse(std::move(request));
+        }));
+}
+
+void AssetStreamer::parse(Request request)
+{
+    auto result = std::make_shared<Parsed>();
+    result->request = std::move(request);
+    try {
+        // big files are parsed in chunks by more jobs
+        OBJLoadSettings settings;
+        settings.jobs = &jobs_;
+        result->ok = std::filesystem::exists(result->request.filename)
+            && loadMeshCached(result->request.filename, result->data, settings);
+    }
+    catch (std::exception const& e) {
+        std::cerr << "Loading failed: " << result->request.filename.string() << ": " << e.what() << '\n';
+        result->ok = false;
+    }
+    parsed_.push_back(result);
+}
+
+void AssetStreamer::update(size_t budget_bytes, double budget_ms)
+{
+    auto start = std::chrono::steady_clock::now();
+    size_t uploaded_bytes = 0;
+
+    std::erase_if(parse_jobs_, [](const JobSystem::JobHandle& job) { return JobSystem::isDone(job); });
+
+    // only GL thread consumes, so non-empty deque can not be emptied by someone else
+    while (!parsed_.empty()) {
+        auto result = parsed_.pop_front();
+        if (!result->ok) {
+            std::cerr << "Loading failed: " << result->request.filename.string() << '\n';
+            pending_--;
+            continue;
+        }
+        uploads_.push_back(Upload{ result, {}, 0, 0, 0 });
+    }
+
+    while (!uploads_.empty()) {
+        Upload& upload = uploads_.front();
+        const auto& submeshes = upload.parsed->data.submeshes;
+
+        if (upload.submesh == submeshes.size()) {
+            // whole model is on GPU
+            upload.parsed->request.on_ready(upload.meshes);
+            uploads_.pop_front();
+            pending_--;
+            continue;
+        }
+
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (uploaded_bytes >= budget_bytes || elapsed.count() >= budget_ms)
+            break;
+        size_t budget_left = budget_bytes - uploaded_bytes;
+
+        const auto& submesh = submeshes[upload.submesh];
+        if (upload.meshes.size() == upload.submesh) {
+            auto mesh = arena_ ? std::make_shared<Mesh>(arena_, submesh.vertices.size(), submesh.indices.size(), GL_TRIANGLES, submesh.bounds)
+                : std::make_shared<Mesh>(submesh.vertices.size(), submesh.indices.size(), GL_TRIANGLES, submesh.bounds);
+            mesh->setBoundingSphere(submesh.sphere);
+            mesh->setLods(submesh.lods);
+            mesh->setMeshlets(submesh.meshlets);
+            upload.meshes.push_back(StreamedMesh{ submesh.name, mesh });
+        }
+        auto& mesh = upload.meshes.back().mesh;
+
+        // vertices first, then indices, always at least one element to make progress
+        if (upload.vertices_done < submesh.vertices.size()) {
+            size_t count = std::clamp<size_t>(budget_left / mesh->getVertexSize(), 1, submesh.vertices.size() - upload.vertices_done);
+            mesh->uploadVertices(upload.vertices_done, submesh.vertices.subspan(upload.vertices_done, count));
+            upload.vertices_done += count;
+            uploaded_bytes += count * mesh->getVertexSize();
+        }
+        else if (upload.indices_done < submesh.indices.size()) {
+            size_t count = std::clamp<size_t>(budget_left / mesh->getIndexSize(), 1, submesh.indices.size() - upload.indices_done);
+            mesh->uploadIndices(upload.indices_done, submesh.indices.subspan(upload.indices_done, count));
+            upload.indices_done += count;
+            uploaded_bytes += count * mesh->getIndexSize();
+        }
+        else {
+            upload.submesh++;
+            upload.vertices_done = 0;
+            upload.indices_done = 0;
+        }
+    }
+}
+
+void AssetStreamer::finish(void)
+{
+    while (pending_ > 0) {
+        update(std::numeric_limits<size_t>::max(), std::numeric_limits<double>::infinity());
+        if (pending_ > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
@@ -0,0 +1,245 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numbers>
+#include <sstream>
+#include <thread>
+
+#include "Benchmark.hpp"
+#include "ObjectLoader.hpp"
+
+namespace {
+    double round_us(double ms) {
+        return std::round(ms * 1000.0) / 1000.0;
+    }
+
+    // nearest rank, values sorted
+    double percentile(const std::vector<double>& values, double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+        return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+    }
+
+    nlohmann::ordered_json statistics(std::vector<double> values) {
+        nlohmann::ordered_json summary;
+        summary["samples"] = values.size();
+        if (values.empty())
+            return summary;
+        std::sort(values.begin(), values.end());
+        double sum = 0.0;
+        for (double v : values)
+            sum += v;
+        summary["min"] = round_us(values.front());
+        summary["avg"] = round_us(sum / values.size());
+        summary["p50"] = round_us(percentile(values, 50.0));
+        summary["p95"] = round_us(percentile(values, 95.0));
+        summary["p99"] = round_us(percentile(values, 99.0));
+        summary["max"] = round_us(values.back());
+        return summary;
+    }
+
+    void create_parent_directory(const std::filesystem::path& output) {
+        if (output.has_parent_path()) {
+            std::error_code ec;
+            std::filesystem::create_directories(output.parent_path(), ec);
+        }
+    }
+
+    // flat grid of 128 quad columns with positions, texture coords and normals, two triangles per quad
+    bool write_grid_obj(const std::filesystem::path& path, size_t triangles) {
+        const size_t columns = 128;
+        size_t rows = std::max<size_t>(1, triangles / (2 * columns));
+
+        std::ofstream file(path);
+        for (size_t z = 0; z <= rows; z++)
+            for (size_t x = 0; x <= columns; x++)
+                file << "v " << x * 0.1f << " 0 " << z * 0.1f << '\n';
+        for (size_t z = 0; z <= rows; z++)
+            for (size_t x = 0; x <= columns; x++)
+                file << "vt " << static_cast<float>(x) / columns << ' ' << static_cast<float>(z) / rows << '\n';
+        file << "vn 0 1 0\n";
+        for (size_t z = 0; z < rows; z++) {
+            for (size_t x = 0; x < columns; x++) {
+                size_t a = z * (columns + 1) + x + 1; // 1-based
+                size_t b = a + 1, c = a + columns + 1, d = c + 1;
+                file << "f " << a << '/' << a << "/1 " << c << '/' << c << "/1 " << b << '/' << b << "/1\n";
+                file << "f " << b << '/' << b << "/1 " << c << '/' << c << "/1 " << d << '/' << d << "/1\n";
+            }
+        }
+        return file.good();
+    }
+
+    // load times in ms of the runs, false if the file can not be loaded
+    bool time_loads(const std::filesystem::path& path, const OBJLoadSettings& settings, std::vector<double>& times, size_t& triangles) {
+        std::vector<SubmeshData> submeshes;
+        if (!loadOBJ(path, submeshes, settings)) // unmeasured, file in the OS cache
+            return false;
+        triangles = 0;
+        for (const auto& submesh : submeshes)
+            triangles += submesh.indices.size() / 3;
+
+        for (int run = 0; run < BENCHMARK_LOADER_RUNS; run++) {
+            auto start = std::chrono::steady_clock::now();
+            if (!loadOBJ(path, submeshes, settings))
+                return false;
+            times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        return true;
+    }
+}
+
+void BenchmarkPath::pose(uint64_t frame, uint64_t frame_count, glm::vec3& position, float& yaw, float& pitch) const
+{
+    double t = frame_count > 0 ? static_cast<double>(frame) / frame_count : 0.0;
+    float angle = static_cast<float>(2.0 * std::numbers::pi * t);
+    position = center + glm::vec3(radius * std::cos(angle), height, radius * std::sin(angle));
+
+    glm::vec3 direction = glm::normalize(center - position);
+    yaw = glm::degrees(std::atan2(direction.z, direction.x));
+    pitch = glm::degrees(std::asin(direction.y));
+}
+
+void BenchmarkRecorder::addFrame(double cpu_ms, const RenderStats& stats)
+{
+    frames_.push_back(Frame{ cpu_ms, -1.0, stats });
+}
+
+void BenchmarkRecorder::setGpuTime(uint64_t frame, double gpu_ms)
+{
+    if (frame < frames_.size())
+        frames_[frame].gpu_ms = gpu_ms;
+}
+
+template <typename Value>
+nlohmann::ordered_json BenchmarkRecorder::summarize(Value value) const
+{
+    std::vector<double> values;
+    for (size_t i = warmup_frames_; i < frames_.size(); i++) {
+        double v = value(frames_[i]);
+        if (v >= 0.0)
+            values.push_back(v);
+    }
+    return statistics(std::move(values));
+}
+
+bool BenchmarkRecorder::write(const std::filesystem::path& output, const nlohmann::ordered_json& info) const
+{
+    create_parent_directory(output);
+
+    nlohmann::ordered_json result = info;
+    result["frames"] = frames_.size() > warmup_frames_ ? frames_.size() - warmup_frames_ : 0;
+    result["cpu_frame_ms"] = summarize([](const Frame& frame) { return frame.cpu_ms; });
+    result["gpu_frame_ms"] = summarize([](const Frame& frame) { return frame.gpu_ms; });
+    result["draw_calls"] = summarize([](const Frame& frame) { return static_cast<double>(frame.stats.draw_calls); });
+    result["draw_commands"] = summarize([](const Frame& frame) { return static_cast<double>(frame.stats.draw_commands); });
+    result["meshes_visible"] = summarize([](const Frame& frame) { return static_cast<double>(frame.stats.meshes_visible); });
+    result["triangles_visible"] = summarize([](const Frame& frame) { return static_cast<double>(frame.stats.triangles_visible); });
+
+    auto json_path = output;
+    json_path += ".json";
+    {
+        std::ofstream file(json_path);
+        file << result.dump(4) << '\n';
+        if (!file.good()) {
+            std::cerr << "Benchmark result can not be written: " << json_path.string() << '\n';
+            return false;
+        }
+    }
+
+    auto csv_path = output;
+    csv_path += ".csv";
+    {
+        std::ofstream file(csv_path);
+        file << "frame,cpu_ms,gpu_ms,draw_calls,draw_commands,meshes_visible,meshes_occluded,triangles_submitted,triangles_visible\n";
+        file << std::fixed << std::setprecision(3);
+        for (size_t i = warmup_frames_; i < frames_.size(); i++) {
+            const auto& frame = frames_[i];
+            file << i - warmup_frames_ << ',' << frame.cpu_ms << ',';
+            if (frame.gpu_ms >= 0.0)
+                file << frame.gpu_ms;
+            file << ',' << frame.stats.draw_calls << ',' << frame.stats.draw_commands << ',' << frame.stats.meshes_visible
+                << ',' << frame.stats.meshes_occluded << ',' << frame.stats.triangles_submitted << ',' << frame.stats.triangles_visible << '\n';
+        }
+        if (!file.good()) {
+            std::cerr << "Benchmark result can not be written: " << csv_path.string() << '\n';
+            return false;
+        }
+    }
+
+    std::cout << "Benchmark: " << result["frames"] << " frames, CPU " << result["cpu_frame_ms"].value("avg", 0.0)
+        << " ms, GPU " << result["gpu_frame_ms"].value("avg", 0.0) << " ms average, written to " << json_path.string() << '\n';
+    return true;
+}
+
+bool benchmarkLoader(const BenchmarkSettings& settings)
+{
+    auto directory = std::filesystem::temp_directory_path() / "icp_loader_benchmark";
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+
+    nlohmann::ordered_json result;
+    result["scene"] = "loader";
+    result["runs"] = BENCHMARK_LOADER_RUNS;
+    result["hardware_threads"] = std::thread::hardware_concurrency();
+    nlohmann::ordered_json sizes = nlohmann::ordered_json::array();
+
+    std::ostringstream csv;
+    csv << "triangles,file_mb,serial_ms,parallel_ms,serial_mtris_per_s,parallel_mtris_per_s\n";
+    csv << std::fixed << std::setprecision(3);
+
+    for (unsigned int i = 0; i < settings.loader_sizes; i++) {
+        auto path = directory / ("grid_" + std::to_string(i) + ".obj");
+        if (!write_grid_obj(path, static_cast<size_t>(BENCHMARK_LOADER_MIN_TRIANGLES) << i)) {
+            std::cerr << "Benchmark mesh can not be written: " << path.string() << '\n';
+            return false;
+        }
+        double file_mb = std::filesystem::file_size(path) / (1024.0 * 1024.0);
+
+        OBJLoadSettings serial;
+        serial.parallel = false;
+        OBJLoadSettings parallel;
+        parallel.parallel = true;
+        std::vector<double> serial_ms, parallel_ms;
+        size_t triangles = 0;
+        bool loaded = time_loads(path, serial, serial_ms, triangles) && time_loads(path, parallel, parallel_ms, triangles);
+        std::filesystem::remove(path, ec);
+        if (!loaded) {
+            std::cerr << "Benchmark mesh can not be loaded: " << path.string() << '\n';
+            return false;
+        }
+
+        nlohmann::ordered_json size;
+        size["triangles"] = triangles;
+        size["file_mb"] = round_us(file_mb);
+        size["serial_ms"] = statistics(serial_ms);
+        size["parallel_ms"] = statistics(parallel_ms);
+        std::sort(serial_ms.begin(), serial_ms.end());
+        std::sort(parallel_ms.begin(), parallel_ms.end());
+        double serial_p50 = percentile(serial_ms, 50.0), parallel_p50 = percentile(parallel_ms, 50.0);
+        sizes.push_back(size);
+
+        // median times, millions of triangles per second
+        csv << triangles << ',' << file_mb << ',' << serial_p50 << ',' << parallel_p50 << ','
+            << triangles / (serial_p50 * 1000.0) << ',' << triangles / (parallel_p50 * 1000.0) << '\n';
+        std::cout << "Loader benchmark: " << triangles << " triangles, " << serial_p50 << " ms serial, " << parallel_p50 << " ms parallel\n";
+    }
+    result["sizes"] = sizes;
+
+    create_parent_directory(settings.output);
+    auto json_path = settings.output;
+    json_path += ".json";
+    auto csv_path = settings.output;
+    csv_path += ".csv";
+    std::ofstream json_file(json_path);
+    json_file << result.dump(4) << '\n';
+    std::ofstream csv_file(csv_path);
+    csv_file << csv.str();
+    if (!json_file.good() || !csv_file.good()) {
+        std::cerr << "Benchmark result can not be written: " << settings.output.string() << '\n';
+        return false;
+    }
+    std::cout << "Loader benchmark written to " << json_path.string() << '\n';
+    return true;
+}
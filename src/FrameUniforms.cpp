@@ -0,0 +1,73 @@
+#include <iostream>
+#include <cstring>
+#include <stdexcept>
+
+#include "FrameUniforms.hpp"
+
+FrameUniforms::FrameUniforms()
+{
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    stride_ = (static_cast<GLsizeiptr>(sizeof(Data)) + alignment - 1) / alignment * alignment;
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &buffer_);
+    glNamedBufferStorage(buffer_, stride_ * FRAME_UNIFORMS_BUFFERING, nullptr, flags);
+    mapped_ = static_cast<char*>(glMapNamedBufferRange(buffer_, 0, stride_ * FRAME_UNIFORMS_BUFFERING, flags));
+    if (!mapped_)
+        throw std::runtime_error("Frame uniform buffer can not be mapped");
+}
+
+FrameUniforms::~FrameUniforms()
+{
+    for (auto fence : fences_)
+        if (fence)
+            glDeleteSync(fence);
+    glUnmapNamedBuffer(buffer_);
+    glDeleteBuffers(1, &buffer_);
+}
+
+bool FrameUniforms::release(size_t index, GLuint64 timeout)
+{
+    GLsync& fence = fences_[index];
+    if (!fence)
+        return true;
+    GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    if (result == GL_TIMEOUT_EXPIRED)
+        return false;
+    if (result == GL_WAIT_FAILED)
+        std::cerr << "Frame uniforms: fence wait failed\n";
+    glDeleteSync(fence);
+    fence = nullptr;
+    return true;
+}
+
+void FrameUniforms::update(const Data& data)
+{
+    // GPU may still read the copy written FRAME_UNIFORMS_BUFFERING frames ago
+    size_t next = (current_ + 1) % fences_.size();
+    if (!release(next, 0) && !release(next, FRAME_UNIFORMS_WAIT_NS)) {
+        // any other copy the GPU is done with
+        size_t other = 1;
+        while (other < fences_.size() && !release((next + other) % fences_.size(), 0))
+            other++;
+        if (other == fences_.size()) {
+            std::cerr << "Frame uniforms: GPU did not release any copy, frame keeps previous data\n";
+            return;
+        }
+        next = (next + other) % fences_.size();
+    }
+    current_ = next;
+
+    data_ = data;
+    std::memcpy(mapped_ + current_ * stride_, &data_, sizeof(Data));
+    glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, buffer_, current_ * stride_, sizeof(Data));
+}
+
+void FrameUniforms::endFrame()
+{
+    // update() skipped the write, the new fence covers the old one
+    if (fences_[current_])
+        glDeleteSync(fences_[current_]);
+    fences_[current_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <atomic>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <immintrin.h>
+#define FRUSTUM_CULLER_SSE 1
+#endif
+
+#include "FrustumCuller.hpp"
+#include "HiZBuffer.hpp"
+#include "JobSystem.hpp"
+
+void FrustumCuller::clear()
+{
+    center_x_.clear();
+    center_y_.clear();
+    center_z_.clear();
+    radius_.clear();
+}
+
+uint32_t FrustumCuller::add(const glm::vec3& center, float radius)
+{
+    center_x_.push_back(center.x);
+    center_y_.push_back(center.y);
+    center_z_.push_back(center.z);
+    radius_.push_back(radius);
+    return static_cast<uint32_t>(radius_.size() - 1);
+}
+
+void FrustumCuller::resize(size_t count)
+{
+    center_x_.resize(count);
+    center_y_.resize(count);
+    center_z_.resize(count);
+    radius_.resize(count);
+}
+
+void FrustumCuller::set(uint32_t index, const glm::vec3& center, float radius)
+{
+    center_x_[index] = center.x;
+    center_y_[index] = center.y;
+    center_z_[index] = center.z;
+    radius_[index] = radius;
+}
+
+void FrustumCuller::cull(const Frustum& frustum, RenderStats& stats, JobSystem* jobs, const HiZBuffer* occlusion)
+{
+    size_t count = radius_.size();
+    visible_.resize(count);
+
+    size_t visible = 0;
+    size_t occluded = 0;
+    if (jobs) {
+        // chunks of whole SSE groups, each writes its own part of visible_
+        std::atomic<size_t> visible_total{ 0 };
+        std::atomic<size_t> occluded_total{ 0 };
+        jobs->parallelFor(count, (JOB_GRAIN_SIZE + 3) / 4 * 4, [&](size_t begin, size_t end) {
+            size_t chunk_occluded = 0;
+            visible_total += cull_range(frustum, occlusion, begin, end, chunk_occluded);
+            occluded_total += chunk_occluded;
+            });
+        visible = visible_total;
+        occluded = occluded_total;
+    }
+    else {
+        visible = cull_range(frustum, occlusion, 0, count, occluded);
+    }
+    stats.meshes_visible += visible;
+    stats.meshes_culled += count - visible - occluded;
+    stats.meshes_occluded += occluded;
+}
+
+size_t FrustumCuller::cull_range(const Frustum& frustum, const HiZBuffer* occlusion, size_t begin, size_t end, size_t& occluded)
+{
+    const auto& planes = frustum.getPlanes();
+    size_t i = begin;
+
+#ifdef FRUSTUM_CULLER_SSE
+    // sphere is outside when it is behind any plane by more than its radius
+    __m128 plane_x[6], plane_y[6], plane_z[6], plane_w[6];
+    for (size_t p = 0; p < planes.size(); p++) {
+        plane_x[p] = _mm_set1_ps(planes[p].x);
+        plane_y[p] = _mm_set1_ps(planes[p].y);
+        plane_z[p] = _mm_set1_ps(planes[p].z);
+        plane_w[p] = _mm_set1_ps(planes[p].w);
+    }
+    for (; i + 4 <= end; i += 4) {
+        __m128 x = _mm_loadu_ps(&center_x_[i]);
+        __m128 y = _mm_loadu_ps(&center_y_[i]);
+        __m128 z = _mm_loadu_ps(&center_z_[i]);
+        __m128 negative_radius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&radius_[i]));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (size_t p = 0; p < planes.size(); p++) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane_x[p], x), _mm_mul_ps(plane_y[p], y)),
+                _mm_add_ps(_mm_mul_ps(plane_z[p], z), plane_w[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negative_radius));
+        }
+        int mask = _mm_movemask_ps(inside);
+        for (size_t k = 0; k < 4; k++)
+            visible_[i + k] = static_cast<uint8_t>((mask >> k) & 1);
+    }
+#endif
+
+    // remainder (or everything without SSE)
+    for (; i < end; i++)
+        visible_[i] = frustum.intersectsSphere(glm::vec3(center_x_[i], center_y_[i], center_z_[i]), radius_[i]);
+
+    // only the few spheres left in the frustum are worth the occlusion test
+    if (occlusion) {
+        for (i = begin; i < end; i++) {
+            if (visible_[i] && occlusion->isOccluded(glm::vec3(center_x_[i], center_y_[i], center_z_[i]), radius_[i])) {
+                visible_[i] = 0;
+                occluded++;
+            }
+        }
+    }
+
+    return static_cast<size_t>(std::count(visible_.begin() + begin, visible_.begin() + end, uint8_t{ 1 }));
+}
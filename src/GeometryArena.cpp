@@ -0,0 +1,103 @@
+#include <iostream>
+#include <iterator>
+
+#include "GeometryArena.hpp"
+
+std::optional<size_t> GeometryArena::RangeAllocator::allocate(size_t size)
+{
+    if (size == 0)
+        return 0;
+    for (auto it = free_.begin(); it != free_.end(); ++it) {
+        if (it->second < size)
+            continue;
+        size_t offset = it->first;
+        size_t remaining = it->second - size;
+        free_.erase(it);
+        if (remaining > 0)
+            free_[offset + size] = remaining;
+        used_ += size;
+        return offset;
+    }
+    return std::nullopt;
+}
+
+void GeometryArena::RangeAllocator::release(size_t offset, size_t size)
+{
+    if (size == 0)
+        return;
+    used_ -= size;
+
+    auto next = free_.lower_bound(offset);
+    if (next != free_.end() && offset + size == next->first) {
+        size += next->second;
+        next = free_.erase(next);
+    }
+    if (next != free_.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            previous->second += size;
+            return;
+        }
+    }
+    free_[offset] = size;
+}
+
+GeometryArena::GeometryArena(size_t vertex_capacity, size_t index_capacity, VertexFormat format) :
+    format_{ format }, vertices_{ vertex_capacity }, indices16_{ index_capacity }, indices32_{ index_capacity }
+{
+    // immutable storage, contents are updated by glNamedBufferSubData()
+    glCreateBuffers(1, &vbo_);
+    glNamedBufferStorage(vbo_, static_cast<GLsizeiptr>(vertex_capacity * vertexSize(format_)), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glCreateBuffers(1, &ebo16_);
+    glNamedBufferStorage(ebo16_, static_cast<GLsizeiptr>(index_capacity * sizeof(GLushort)), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glCreateBuffers(1, &ebo32_);
+    glNamedBufferStorage(ebo32_, static_cast<GLsizeiptr>(index_capacity * sizeof(GLuint)), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    for (auto [vao, ebo] : { std::pair{ &vao16_, ebo16_ }, std::pair{ &vao32_, ebo32_ } }) {
+        glCreateVertexArrays(1, vao);
+        setupVertexAttributes(*vao, format_);
+        glVertexArrayVertexBuffer(*vao, 0, vbo_, 0, static_cast<GLsizei>(vertexSize(format_)));
+        glVertexArrayElementBuffer(*vao, ebo);
+    }
+
+    std::cout << "Geometry arena: " << capacityBytes() / (1 << 20) << " MB\n";
+}
+
+GeometryArena::~GeometryArena()
+{
+    glDeleteVertexArrays(1, &vao16_);
+    glDeleteVertexArrays(1, &vao32_);
+    glDeleteBuffers(1, &ebo16_);
+    glDeleteBuffers(1, &ebo32_);
+    glDeleteBuffers(1, &vbo_);
+}
+
+std::optional<GeometryArena::Allocation> GeometryArena::allocate(size_t vertex_count, size_t index_count, GLenum index_type)
+{
+    auto& indices = index_type == GL_UNSIGNED_SHORT ? indices16_ : indices32_;
+    auto first_vertex = vertices_.allocate(vertex_count);
+    if (!first_vertex)
+        return std::nullopt;
+    auto first_index = indices.allocate(index_count);
+    if (!first_index) {
+        vertices_.release(*first_vertex, vertex_count);
+        return std::nullopt;
+    }
+    return Allocation{ *first_vertex, vertex_count, *first_index, index_count, index_type };
+}
+
+void GeometryArena::release(const Allocation& allocation)
+{
+    vertices_.release(allocation.first_vertex, allocation.vertex_count);
+    (allocation.index_type == GL_UNSIGNED_SHORT ? indices16_ : indices32_).release(allocation.first_index, allocation.index_count);
+}
+
+size_t GeometryArena::usedBytes() const
+{
+    return vertices_.used() * vertexSize(format_) + indices16_.used() * sizeof(GLushort) + indices32_.used() * sizeof(GLuint);
+}
+
+size_t GeometryArena::capacityBytes() const
+{
+    return vertices_.capacity() * vertexSize(format_) + indices16_.capacity() * sizeof(GLushort) + indices32_.capacity() * sizeof(GLuint);
+}
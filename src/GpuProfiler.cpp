@@ -0,0 +1,114 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+
+#include "GpuProfiler.hpp"
+
+GpuProfiler::~GpuProfiler()
+{
+    for (auto& frame : frames_)
+        glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+}
+
+void GpuProfiler::beginFrame()
+{
+    current_ = (current_ + 1) % frames_.size();
+    Frame& frame = frames_[current_];
+
+    // the oldest frame of the ring, GPU_PROFILER_FRAMES - 1 frames ago
+    if (frame.pending)
+        collect(frame);
+    frame.used = 0;
+    frame.entries.clear();
+    frame.pending = false;
+}
+
+void GpuProfiler::endFrame()
+{
+    Frame& frame = frames_[current_];
+    frame.pending = !frame.entries.empty();
+
+    if (GPU_PROFILER_LOG_INTERVAL > 0.0) {
+        auto now = std::chrono::steady_clock::now();
+        if (std::chrono::duration<double>(now - last_log_).count() >= GPU_PROFILER_LOG_INTERVAL) {
+            log(std::cout);
+            last_log_ = now;
+        }
+    }
+}
+
+GLuint GpuProfiler::next_query()
+{
+    Frame& frame = frames_[current_];
+    if (frame.used == frame.queries.size()) {
+        frame.queries.resize(std::max<size_t>(16, frame.queries.size() * 2));
+        glCreateQueries(GL_TIMESTAMP, static_cast<GLsizei>(frame.queries.size() - frame.used), frame.queries.data() + frame.used);
+    }
+    return frame.queries[frame.used++];
+}
+
+size_t GpuProfiler::scope_index(std::string_view name)
+{
+    for (size_t i = 0; i < scopes_.size(); i++)
+        if (scopes_[i].name == name)
+            return i;
+    scopes_.push_back(ScopeTime{ std::string(name) });
+    return scopes_.size() - 1;
+}
+
+size_t GpuProfiler::begin(std::string_view name)
+{
+    Frame& frame = frames_[current_];
+    Entry entry{ scope_index(name), next_query() };
+    glQueryCounter(entry.begin_query, GL_TIMESTAMP);
+    frame.entries.push_back(entry);
+    return frame.entries.size() - 1;
+}
+
+void GpuProfiler::end(size_t entry)
+{
+    Frame& frame = frames_[current_];
+    frame.entries[entry].end_query = next_query();
+    glQueryCounter(frame.entries[entry].end_query, GL_TIMESTAMP);
+}
+
+void GpuProfiler::collect(Frame& frame)
+{
+    // timestamps complete in order, the last query written decides for all
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available && !wait_for_results_) {
+        dropped_frames_++;
+        return;
+    }
+
+    frame_ms_.assign(scopes_.size(), -1.0);
+    for (const auto& entry : frame.entries) {
+        if (entry.end_query == 0)
+            continue; // scope not closed within the frame
+        GLuint64 begin_ns = 0, end_ns = 0;
+        glGetQueryObjectui64v(entry.begin_query, GL_QUERY_RESULT, &begin_ns);
+        glGetQueryObjectui64v(entry.end_query, GL_QUERY_RESULT, &end_ns);
+        double& ms = frame_ms_[entry.scope];
+        ms = std::max(ms, 0.0) + static_cast<double>(end_ns - begin_ns) * 1e-6;
+    }
+
+    for (size_t i = 0; i < scopes_.size(); i++) {
+        if (frame_ms_[i] < 0.0)
+            continue; // not used in that frame
+        auto& scope = scopes_[i];
+        scope.last_ms = frame_ms_[i];
+        scope.average_ms = scope.average_ms == 0.0 ? scope.last_ms : scope.average_ms + GPU_PROFILER_SMOOTHING * (scope.last_ms - scope.average_ms);
+    }
+    measured_frames_++;
+}
+
+void GpuProfiler::log(std::ostream& out) const
+{
+    std::ostringstream line;
+    line << "GPU time:" << std::fixed << std::setprecision(3);
+    for (const auto& scope : scopes_)
+        line << ' ' << scope.name << ' ' << scope.average_ms << " ms";
+    out << line.str() << '\n';
+}
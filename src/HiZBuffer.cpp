@@ -0,0 +1,235 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "HiZBuffer.hpp"
+
+namespace {
+    bool signaled(GLsync fence, bool wait) {
+        // flush, so that the fence is reached even if nothing else is submitted meanwhile
+        GLenum status = glClientWaitSync(fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? 1000000000 : 0);
+        while (wait && status == GL_TIMEOUT_EXPIRED)
+            status = glClientWaitSync(fence, 0, 1000000000);
+        return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+    }
+}
+
+HiZBuffer::HiZBuffer(std::shared_ptr<ShaderProgram> reduce_shader)
+    : reduce_shader_(std::move(reduce_shader))
+{
+    source_level_ = reduce_shader_->getUniform<GLint>("uSourceLevel");
+}
+
+HiZBuffer::~HiZBuffer()
+{
+    release();
+}
+
+void HiZBuffer::release(void)
+{
+    for (auto& readback : readbacks_) {
+        if (readback.fence)
+            glDeleteSync(readback.fence);
+        if (readback.buffer)
+            glDeleteBuffers(1, &readback.buffer);
+        readback = Readback{};
+    }
+    if (depth_framebuffer_)
+        glDeleteFramebuffers(1, &depth_framebuffer_);
+    if (depth_texture_)
+        glDeleteTextures(1, &depth_texture_);
+    if (pyramid_)
+        glDeleteTextures(1, &pyramid_);
+    depth_framebuffer_ = depth_texture_ = pyramid_ = 0;
+}
+
+void HiZBuffer::resize(GLsizei width, GLsizei height)
+{
+    // readbacks in flight are dropped, the CPU pyramid stays valid for its own viewport
+    release();
+    width_ = width;
+    height_ = height;
+
+    // same format as the rendered framebuffer (24 bit depth, 8 bit stencil), required by the blit
+    glCreateTextures(GL_TEXTURE_2D, 1, &depth_texture_);
+    glTextureStorage2D(depth_texture_, 1, GL_DEPTH24_STENCIL8, width, height);
+    glTextureParameteri(depth_texture_, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(depth_texture_, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glCreateFramebuffers(1, &depth_framebuffer_);
+    glNamedFramebufferTexture(depth_framebuffer_, GL_DEPTH_STENCIL_ATTACHMENT, depth_texture_, 0);
+
+    // half resolution down to the readback level
+    glm::ivec2 base{ std::max(1, width / 2), std::max(1, height / 2) };
+    glm::ivec2 size = base;
+    pyramid_levels_ = 1;
+    while (size.x > HIZ_READBACK_WIDTH) {
+        size = glm::max(size / 2, glm::ivec2(1));
+        pyramid_levels_++;
+    }
+    readback_size_ = size;
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &pyramid_);
+    glTextureStorage2D(pyramid_, pyramid_levels_, GL_R32F, base.x, base.y);
+    glTextureParameteri(pyramid_, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTextureParameteri(pyramid_, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    for (auto& readback : readbacks_) {
+        glCreateBuffers(1, &readback.buffer);
+        glNamedBufferStorage(readback.buffer, readback_size_.x * readback_size_.y * sizeof(float), nullptr, GL_MAP_READ_BIT);
+    }
+}
+
+void HiZBuffer::build(GLuint framebuffer, GLsizei width, GLsizei height, const glm::mat4& view_projection)
+{
+    if (width <= 0 || height <= 0)
+        return;
+    if (width != width_ || height != height_)
+        resize(width, height);
+
+    // GPU is behind by all buffers, skip this frame rather than wait (unless waiting for results)
+    Readback& readback = readbacks_[frame_ % HIZ_READBACK_BUFFERS];
+    if (readback.fence) {
+        if (!signaled(readback.fence, wait_for_results_))
+            return;
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+    }
+
+    glBlitNamedFramebuffer(framebuffer, depth_framebuffer_, 0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+    reduce_shader_->use();
+    glm::ivec2 size{ std::max(1, width / 2), std::max(1, height / 2) };
+    for (GLsizei level = 0; level < pyramid_levels_; level++) {
+        glBindTextureUnit(0, level == 0 ? depth_texture_ : pyramid_);
+        source_level_.set(level == 0 ? 0 : level - 1);
+        glBindImageTexture(0, pyramid_, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute((size.x + 7) / 8, (size.y + 7) / 8, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+        size = glm::max(size / 2, glm::ivec2(1));
+    }
+    glBindTextureUnit(0, 0);
+
+    // copy to PBO, finishes asynchronously
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    glGetTextureImage(pyramid_, pyramid_levels_ - 1, GL_RED, GL_FLOAT, readback_size_.x * readback_size_.y * sizeof(float), nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.view_projection = view_projection;
+    readback.frame = ++frame_;
+}
+
+void HiZBuffer::fetch(void)
+{
+    Readback* newest = nullptr;
+    if (wait_for_results_) {
+        // fixed latency, the oldest readback of the ring
+        for (auto& readback : readbacks_)
+            if (readback.fence && readback.frame + HIZ_READBACK_BUFFERS - 1 == frame_)
+                newest = &readback;
+        if (newest && !signaled(newest->fence, true))
+            newest = nullptr;
+    }
+    else {
+        for (auto& readback : readbacks_) {
+            if (!readback.fence || (newest && readback.frame < newest->frame))
+                continue;
+            if (signaled(readback.fence, false))
+                newest = &readback;
+        }
+    }
+    if (!newest)
+        return;
+
+    // older readbacks are obsolete
+    for (auto& readback : readbacks_) {
+        if (readback.fence && readback.frame <= newest->frame) {
+            glDeleteSync(readback.fence);
+            readback.fence = nullptr;
+        }
+    }
+
+    glm::ivec2 size = readback_size_;
+    levels_.resize(1);
+    levels_[0].resize(size.x * size.y);
+    level_sizes_.assign(1, size);
+    auto data = glMapNamedBufferRange(newest->buffer, 0, levels_[0].size() * sizeof(float), GL_MAP_READ_BIT);
+    if (!data) {
+        levels_.clear();
+        return;
+    }
+    std::memcpy(levels_[0].data(), data, levels_[0].size() * sizeof(float));
+    glUnmapNamedBuffer(newest->buffer);
+
+    view_projection_ = newest->view_projection;
+    viewport_ = glm::vec2(width_, height_);
+    texel_pixels_ = static_cast<float>(1 << pyramid_levels_);
+
+    // coarser levels down to 1x1, same reduction as the shader
+    while (size.x > 1 || size.y > 1) {
+        glm::ivec2 next = glm::max(size / 2, glm::ivec2(1));
+        const auto& source = levels_.back();
+        std::vector<float> level(next.x * next.y);
+        for (int y = 0; y < next.y; y++) {
+            int y1 = (y == next.y - 1) ? size.y - 1 : std::min(2 * y + 1, size.y - 1);
+            for (int x = 0; x < next.x; x++) {
+                int x1 = (x == next.x - 1) ? size.x - 1 : std::min(2 * x + 1, size.x - 1);
+                float depth = 0.0f;
+                for (int sy = 2 * y; sy <= y1; sy++)
+                    for (int sx = 2 * x; sx <= x1; sx++)
+                        depth = std::max(depth, source[sy * size.x + sx]);
+                level[y * next.x + x] = depth;
+            }
+        }
+        levels_.push_back(std::move(level));
+        level_sizes_.push_back(next);
+        size = next;
+    }
+}
+
+bool HiZBuffer::isOccluded(const glm::vec3& center, float radius) const
+{
+    if (levels_.empty())
+        return false;
+
+    // screen rectangle and nearest depth of the sphere's bounding box, in the frame of the depth
+    glm::vec4 clip_center = view_projection_ * glm::vec4(center, 1.0f);
+    glm::vec4 axes[3] = { view_projection_[0] * radius, view_projection_[1] * radius, view_projection_[2] * radius };
+    glm::vec3 low(std::numeric_limits<float>::infinity());
+    glm::vec3 high(-std::numeric_limits<float>::infinity());
+    for (int k = 0; k < 8; k++) {
+        glm::vec4 corner = clip_center + ((k & 1) ? axes[0] : -axes[0]) + ((k & 2) ? axes[1] : -axes[1]) + ((k & 4) ? axes[2] : -axes[2]);
+        if (corner.w <= 0.0f)
+            return false; // reaches behind the camera
+        glm::vec3 ndc = glm::vec3(corner) / corner.w;
+        low = glm::min(low, ndc);
+        high = glm::max(high, ndc);
+    }
+    // crossing the near plane, or not in the depth at all (frustum culling decides)
+    if (low.z < -1.0f || high.x < -1.0f || low.x > 1.0f || high.y < -1.0f || low.y > 1.0f)
+        return false;
+    float nearest = low.z * 0.5f + 0.5f;
+
+    // in texels of level 0, then the level where the rectangle spans at most 2x2 texels
+    glm::vec2 first = (glm::clamp(glm::vec2(low), -1.0f, 1.0f) * 0.5f + 0.5f) * viewport_ / texel_pixels_;
+    glm::vec2 last = (glm::clamp(glm::vec2(high), -1.0f, 1.0f) * 0.5f + 0.5f) * viewport_ / texel_pixels_;
+    float extent = std::max(last.x - first.x, last.y - first.y);
+    size_t level = extent > 1.0f ? static_cast<size_t>(std::ceil(std::log2(extent))) : 0;
+    level = std::min(level, levels_.size() - 1);
+
+    const glm::ivec2& size = level_sizes_[level];
+    float scale = 1.0f / static_cast<float>(1u << level);
+    // the last texel of a level covers the rest of the viewport
+    int x0 = std::min(static_cast<int>(first.x * scale), size.x - 1);
+    int x1 = std::min(static_cast<int>(last.x * scale), size.x - 1);
+    int y0 = std::min(static_cast<int>(first.y * scale), size.y - 1);
+    int y1 = std::min(static_cast<int>(last.y * scale), size.y - 1);
+
+    const auto& depth = levels_[level];
+    for (int y = y0; y <= y1; y++)
+        for (int x = x0; x <= x1; x++)
+            if (depth[y * size.x + x] >= nearest)
+                return false;
+    return true;
+}
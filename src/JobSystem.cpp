@@ -0,0 +1,331 @@
+#include <iostream>
+#include <algorithm>
+#include <exception>
+
+#include "JobSystem.hpp"
+
+namespace {
+    // worker identity of the current thread
+    thread_local const JobSystem* current_system = nullptr;
+    thread_local unsigned int current_worker = 0;
+    // jobs executed inside jobs (while waiting) are not counted twice as busy time
+    thread_local unsigned int execute_depth = 0;
+}
+
+JobSystem::JobSystem(unsigned int thread_count)
+{
+    if (thread_count == 0)
+        thread_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+    background_limit_ = std::max(1u, thread_count - 1);
+    for (unsigned int i = 0; i < thread_count; i++)
+        queues_.push_back(std::make_unique<Queue>());
+    for (unsigned int i = 0; i < thread_count; i++)
+        workers_.emplace_back(&JobSystem::worker_func, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::scoped_lock lock(sleep_mutex_);
+        terminate_ = true;
+    }
+    sleep_cv_.notify_all();
+    for (auto& worker : workers_)
+        worker.join();
+}
+
+JobSystem::JobHandle JobSystem::submit(Task task, std::initializer_list<JobHandle> dependencies)
+{
+    auto job = std::make_shared<Job>();
+    job->task = std::move(task);
+    job->dependencies.assign(dependencies.begin(), dependencies.end());
+
+    // unfinished dependencies queue the job when they finish
+    for (const auto& dependency : dependencies) {
+        if (!dependency)
+            continue;
+        std::scoped_lock lock(dependency->mutex);
+        if (!dependency->done) {
+            job->pending++;
+            dependency->continuations.push_back(job);
+        }
+    }
+    if (--job->pending == 0)
+        enqueue(job);
+    return job;
+}
+
+JobSystem::JobHandle JobSystem::submitBackground(Task task)
+{
+    auto job = std::make_shared<Job>();
+    job->task = std::move(task);
+    job->background = true;
+    job->pending = 0;
+    enqueue(job);
+    return job;
+}
+
+bool JobSystem::isDone(const JobHandle& job)
+{
+    return !job || job->done;
+}
+
+void JobSystem::wait(const JobHandle& job)
+{
+    if (isDone(job))
+        return;
+    if (worker_index() == not_a_worker)
+        help(job);
+    waitUntil([&job]() { return isDone(job); });
+}
+
+void JobSystem::waitUntil(const std::function<bool()>& done)
+{
+    unsigned int self = worker_index();
+    if (self != not_a_worker) {
+        while (!done()) {
+            if (!run_one(self))
+                std::this_thread::yield();
+        }
+        return;
+    }
+
+    // unrelated jobs may take long, other threads just block; timeout for conditions not set by jobs
+    waiters_++;
+    {
+        std::unique_lock lock(done_mutex_);
+        while (!done())
+            done_cv_.wait_for(lock, std::chrono::milliseconds(1));
+    }
+    waiters_--;
+}
+
+void JobSystem::help(const JobHandle& job)
+{
+    // the job and its dependencies run on this thread, unless a worker took them already
+    if (job->background)
+        return;
+    for (const auto& dependency : job->dependencies) {
+        if (!isDone(dependency)) {
+            help(dependency);
+            waitUntil([&dependency]() { return isDone(dependency); });
+        }
+    }
+    // its entry in a queue is skipped later
+    if (job->pending == 0 && !job->claimed.exchange(true))
+        execute(job, not_a_worker);
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)>& body)
+{
+    grain = std::max<size_t>(grain, 1);
+    size_t chunks = (count + grain - 1) / grain;
+    if (chunks <= 1 || workers_.empty()) {
+        if (count > 0)
+            body(0, count);
+        return;
+    }
+
+    // helpers and the caller take chunks until none is left, late helpers find nothing to do;
+    // the first exception stops taking further chunks
+    std::atomic<size_t> next{ 0 };
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    auto work = [&]() {
+        try {
+            for (size_t chunk; (chunk = next.fetch_add(1)) < chunks;)
+                body(chunk * grain, std::min(count, (chunk + 1) * grain));
+        }
+        catch (...) {
+            std::scoped_lock lock(error_mutex);
+            if (!error)
+                error = std::current_exception();
+            next = chunks;
+        }
+    };
+    std::vector<JobHandle> helpers;
+    size_t helper_count = std::min<size_t>(chunks - 1, workers_.size());
+    for (size_t i = 0; i < helper_count; i++)
+        helpers.push_back(submit(work));
+
+    // helpers refer to this stack frame
+    work();
+    for (const auto& helper : helpers)
+        wait(helper);
+    if (error)
+        std::rethrow_exception(error);
+}
+
+std::vector<JobSystem::WorkerStats> JobSystem::sampleStats()
+{
+    auto now = std::chrono::steady_clock::now();
+    double interval_ns = std::chrono::duration<double, std::nano>(now - sample_time_).count();
+    sample_time_ = now;
+
+    std::vector<WorkerStats> stats;
+    for (auto& queue : queues_) {
+        uint64_t busy = queue->busy_ns, jobs = queue->executed, steals = queue->steals;
+        WorkerStats worker;
+        worker.utilization = interval_ns > 0.0 ? std::min(1.0, (busy - queue->sampled_busy_ns) / interval_ns) : 0.0;
+        worker.jobs = jobs - queue->sampled_jobs;
+        worker.steals = steals - queue->sampled_steals;
+        queue->sampled_busy_ns = busy;
+        queue->sampled_jobs = jobs;
+        queue->sampled_steals = steals;
+        stats.push_back(worker);
+    }
+    return stats;
+}
+
+void JobSystem::worker_func(unsigned int index)
+{
+    current_system = this;
+    current_worker = index;
+
+    while (true) {
+        if (run_one(index) || run_background(index))
+            continue;
+        std::unique_lock lock(sleep_mutex_);
+        sleep_cv_.wait(lock, [this]() { return terminate_ || queued_ > 0 || background_runnable(); });
+        if (terminate_ && queued_ == 0 && background_queued_ == 0)
+            return;
+        if (terminate_ && queued_ == 0 && !background_runnable()) {
+            // background jobs left for the other workers
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+unsigned int JobSystem::worker_index() const
+{
+    return current_system == this ? current_worker : not_a_worker;
+}
+
+void JobSystem::enqueue(JobHandle job)
+{
+    // counted before it can be taken, so that the counters never go below zero
+    if (job->background) {
+        std::scoped_lock lock(background_mutex_);
+        background_queued_++;
+        background_jobs_.push_back(std::move(job));
+    }
+    else {
+        // own deque of a worker, other threads spread jobs round robin
+        unsigned int self = worker_index();
+        unsigned int target = self != not_a_worker ? self : next_queue_++ % queues_.size();
+        std::scoped_lock lock(queues_[target]->mutex);
+        queued_++;
+        queues_[target]->jobs.push_back(std::move(job));
+    }
+    // empty critical section orders the increment before a worker's check of the wait predicate
+    { std::scoped_lock lock(sleep_mutex_); }
+    sleep_cv_.notify_one();
+}
+
+bool JobSystem::run_one(unsigned int self)
+{
+    JobHandle job;
+    if (self != not_a_worker) {
+        auto& own = *queues_[self];
+        std::scoped_lock lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+        }
+    }
+
+    // steal the oldest job of another queue
+    bool stolen = false;
+    size_t count = queues_.size();
+    size_t start = self != not_a_worker ? self + 1 : 0;
+    for (size_t k = 0; !job && k < count; k++) {
+        size_t victim_index = (start + k) % count;
+        if (victim_index == self)
+            continue;
+        auto& victim = *queues_[victim_index];
+        std::scoped_lock lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            stolen = true;
+        }
+    }
+    if (!job)
+        return false;
+
+    queued_--;
+    if (job->claimed.exchange(true))
+        return true; // run by the thread waiting for it
+    if (stolen && self != not_a_worker)
+        queues_[self]->steals++;
+    execute(job, self);
+    return true;
+}
+
+bool JobSystem::run_background(unsigned int self)
+{
+    // keep a worker free for short jobs
+    if (background_running_++ >= background_limit_) {
+        background_running_--;
+        return false;
+    }
+    JobHandle job;
+    {
+        std::scoped_lock lock(background_mutex_);
+        if (!background_jobs_.empty()) {
+            job = std::move(background_jobs_.front());
+            background_jobs_.pop_front();
+            background_queued_--;
+        }
+    }
+    if (job && !job->claimed.exchange(true))
+        execute(job, self);
+    background_running_--;
+    if (!job)
+        return false;
+
+    // the slot may be taken by a sleeping worker
+    { std::scoped_lock lock(sleep_mutex_); }
+    sleep_cv_.notify_one();
+    return true;
+}
+
+void JobSystem::execute(const JobHandle& job, unsigned int self)
+{
+    auto start = std::chrono::steady_clock::now();
+    execute_depth++;
+    try {
+        job->task();
+    }
+    catch (std::exception const& e) {
+        std::cerr << "Job failed: " << e.what() << '\n';
+    }
+    catch (...) {
+        std::cerr << "Job failed: unknown exception\n";
+    }
+    execute_depth--;
+    job->task = nullptr; // release captures before dependants run
+
+    std::vector<JobHandle> continuations;
+    {
+        std::scoped_lock lock(job->mutex);
+        job->done = true;
+        continuations.swap(job->continuations);
+    }
+    for (auto& continuation : continuations)
+        if (--continuation->pending == 0)
+            enqueue(std::move(continuation));
+    if (waiters_ > 0) {
+        { std::scoped_lock lock(done_mutex_); }
+        done_cv_.notify_all();
+    }
+
+    if (self != not_a_worker) {
+        auto& queue = *queues_[self];
+        if (execute_depth == 0)
+            queue.busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        queue.executed++;
+    }
+}
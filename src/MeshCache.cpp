@@ -0,0 +1,238 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <string_view>
+
+#include "MeshCache.hpp"
+#include "Hash.hpp"
+#include "Mesh.hpp"
+
+namespace {
+    int64_t file_mtime(const std::filesystem::path& path) {
+        return static_cast<int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+    }
+
+    uint64_t path_hash(const std::filesystem::path& path) {
+        return fnv1a(std::filesystem::weakly_canonical(path).generic_string());
+    }
+
+    // header of the cache file for the current Vertex layout
+    MeshCacheHeader expected_header(const OBJLoadSettings& settings, const MeshOptimizeSettings& optimize, const MeshLodSettings& lod_settings) {
+        MeshCacheHeader header{};
+        std::memcpy(header.magic, "ICPM", 4);
+        header.version = MESH_CACHE_VERSION;
+        header.vertex_stride = sizeof(Vertex);
+        header.attribute_count = 3;
+        header.attributes[0] = { Mesh::attribute_location_position, glm::vec3::length(), GL_FLOAT, offsetof(Vertex, position) };
+        header.attributes[1] = { Mesh::attribute_location_normal, glm::vec3::length(), GL_FLOAT, offsetof(Vertex, normal) };
+        header.attributes[2] = { Mesh::attribute_location_texture_coords, glm::vec2::length(), GL_FLOAT, offsetof(Vertex, texCoords) };
+        header.index_type = GL_UNSIGNED_INT;
+        if (optimize.vertex_cache)
+            header.flags |= MESH_CACHE_FLAG_VERTEX_CACHE;
+        if (optimize.overdraw)
+            header.flags |= MESH_CACHE_FLAG_OVERDRAW;
+        if (optimize.vertex_fetch)
+            header.flags |= MESH_CACHE_FLAG_VERTEX_FETCH;
+        // simulated cache size changes the triangle order
+        if (optimize.enabled())
+            header.optimize_cache_size = optimize.cache_size;
+        if (lod_settings.enabled()) {
+            std::string_view key(reinterpret_cast<const char*>(&lod_settings), sizeof(lod_settings));
+            header.lod_settings_hash = static_cast<uint32_t>(fnv1a(key));
+        }
+        header.meshlet_limits[0] = MESHLET_MAX_VERTICES;
+        header.meshlet_limits[1] = MESHLET_MAX_TRIANGLES;
+        header.meshlet_limits[2] = MESHLET_MIN_MESH_TRIANGLES;
+        // parallel parsing gives the same result, it is not a part of the key
+        std::string load_key = std::to_string(settings.weld_epsilon) + (settings.split_groups ? "/split" : "/whole");
+        header.load_settings_hash = static_cast<uint32_t>(fnv1a(load_key));
+        return header;
+    }
+
+    bool same_layout(const MeshCacheHeader& a, const MeshCacheHeader& b) {
+        return std::memcmp(a.magic, b.magic, sizeof(a.magic)) == 0
+            && a.version == b.version
+            && a.vertex_stride == b.vertex_stride
+            && a.attribute_count == b.attribute_count
+            && std::memcmp(a.attributes, b.attributes, sizeof(a.attributes)) == 0
+            && a.index_type == b.index_type
+            && a.flags == b.flags
+            && a.lod_settings_hash == b.lod_settings_hash
+            && std::memcmp(a.meshlet_limits, b.meshlet_limits, sizeof(a.meshlet_limits)) == 0
+            && a.load_settings_hash == b.load_settings_hash
+            && a.optimize_cache_size == b.optimize_cache_size;
+    }
+
+    // Validates the cache against the source. Returns false if the cache must be regenerated.
+    bool open_cache(const std::filesystem::path& source, const std::filesystem::path& cache_path, CachedMesh& mesh,
+        const OBJLoadSettings& settings, const MeshOptimizeSettings& optimize, const MeshLodSettings& lod_settings) {
+        if (!std::filesystem::exists(cache_path))
+            return false;
+
+        MeshCacheHeader header;
+        {
+            std::ifstream file(cache_path, std::ios::binary);
+            if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+                return false;
+        }
+
+        if (!same_layout(header, expected_header(settings, optimize, lod_settings)) || header.source_path_hash != path_hash(source))
+            return false;
+
+        size_t expected_size = sizeof(MeshCacheHeader) + header.submesh_count * sizeof(MeshCacheSubmesh)
+            + header.vertex_count * sizeof(Vertex) + header.index_count * sizeof(GLuint) + header.meshlet_count * sizeof(Meshlet);
+        if (std::filesystem::file_size(cache_path) != expected_size)
+            return false;
+
+        // cheap check first, content hash only if the source was touched
+        auto source_mtime = file_mtime(source);
+        auto source_size = std::filesystem::file_size(source);
+        if (header.source_mtime != source_mtime || header.source_size != source_size) {
+            MappedFile source_file(source);
+            if (!source_file.is_open() || fnv1a(source_file.view()) != header.source_content_hash)
+                return false;
+
+            // same content, just refresh the timestamp to skip hashing next time
+            header.source_mtime = static_cast<int64_t>(source_mtime);
+            header.source_size = source_size;
+            std::fstream file(cache_path, std::ios::in | std::ios::out | std::ios::binary);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+
+        MappedFile mapping(cache_path);
+        if (!mapping.is_open() || mapping.size() != expected_size)
+            return false;
+
+        const char* table = mapping.data() + sizeof(MeshCacheHeader);
+        auto vertices = reinterpret_cast<const Vertex*>(table + header.submesh_count * sizeof(MeshCacheSubmesh));
+        auto indices = reinterpret_cast<const GLuint*>(vertices + header.vertex_count);
+        auto meshlets = reinterpret_cast<const Meshlet*>(indices + header.index_count);
+
+        mesh.submeshes.clear();
+        for (uint32_t i = 0; i < header.submesh_count; i++) {
+            MeshCacheSubmesh entry;
+            std::memcpy(&entry, table + i * sizeof(MeshCacheSubmesh), sizeof(entry));
+            if (entry.first_vertex + entry.vertex_count > header.vertex_count || entry.first_index + entry.index_count > header.index_count
+                || entry.lod_count > MESH_CACHE_MAX_LODS || entry.first_meshlet + entry.meshlet_count > header.meshlet_count)
+                return false;
+
+            CachedSubmesh submesh;
+            submesh.name = std::string(entry.name, strnlen(entry.name, sizeof(entry.name)));
+            submesh.vertices = std::span<const Vertex>(vertices + entry.first_vertex, entry.vertex_count);
+            submesh.indices = std::span<const GLuint>(indices + entry.first_index, entry.index_count);
+            submesh.bounds.min_point = glm::vec3(entry.bounds_min[0], entry.bounds_min[1], entry.bounds_min[2]);
+            submesh.bounds.max_point = glm::vec3(entry.bounds_max[0], entry.bounds_max[1], entry.bounds_max[2]);
+            submesh.sphere = BoundingSphere{ glm::vec3(entry.sphere[0], entry.sphere[1], entry.sphere[2]), entry.sphere[3] };
+            submesh.lods.assign(entry.lods, entry.lods + entry.lod_count);
+            submesh.meshlets = std::span<const Meshlet>(meshlets + entry.first_meshlet, entry.meshlet_count);
+            mesh.submeshes.push_back(std::move(submesh));
+        }
+        mesh.mapping = std::move(mapping);
+        mesh.from_cache = true;
+        return true;
+    }
+
+    bool write_cache(const std::filesystem::path& source, const std::filesystem::path& cache_path, const CachedMesh& mesh,
+        const OBJLoadSettings& settings, const MeshOptimizeSettings& optimize, const MeshLodSettings& lod_settings) {
+        MappedFile source_file(source);
+        if (!source_file.is_open())
+            return false;
+
+        MeshCacheHeader header = expected_header(settings, optimize, lod_settings);
+        header.source_path_hash = path_hash(source);
+        header.source_mtime = file_mtime(source);
+        header.source_size = source_file.size();
+        header.source_content_hash = fnv1a(source_file.view());
+        header.submesh_count = static_cast<uint32_t>(mesh.submeshes.size());
+
+        std::vector<MeshCacheSubmesh> table;
+        for (const auto& submesh : mesh.submeshes) {
+            MeshCacheSubmesh entry{};
+            submesh.name.copy(entry.name, sizeof(entry.name) - 1);
+            entry.first_vertex = header.vertex_count;
+            entry.vertex_count = submesh.vertices.size();
+            entry.first_index = header.index_count;
+            entry.index_count = submesh.indices.size();
+            for (int k = 0; k < 3; k++) {
+                entry.bounds_min[k] = submesh.bounds.min_point[k];
+                entry.bounds_max[k] = submesh.bounds.max_point[k];
+                entry.sphere[k] = submesh.sphere.center[k];
+            }
+            entry.sphere[3] = submesh.sphere.radius;
+            entry.lod_count = static_cast<uint32_t>(std::min<size_t>(submesh.lods.size(), MESH_CACHE_MAX_LODS));
+            std::copy_n(submesh.lods.begin(), entry.lod_count, entry.lods);
+            entry.first_meshlet = header.meshlet_count;
+            entry.meshlet_count = submesh.meshlets.size();
+            header.vertex_count += entry.vertex_count;
+            header.index_count += entry.index_count;
+            header.meshlet_count += entry.meshlet_count;
+            table.push_back(entry);
+        }
+
+        // write to temporary file and rename, so that interrupted write never leaves valid-looking cache
+        auto temp_path = cache_path;
+        temp_path += ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            if (!file.is_open())
+                return false;
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(MeshCacheSubmesh));
+            for (const auto& submesh : mesh.submeshes)
+                file.write(reinterpret_cast<const char*>(submesh.vertices.data()), submesh.vertices.size_bytes());
+            for (const auto& submesh : mesh.submeshes)
+                file.write(reinterpret_cast<const char*>(submesh.indices.data()), submesh.indices.size_bytes());
+            for (const auto& submesh : mesh.submeshes)
+                file.write(reinterpret_cast<const char*>(submesh.meshlets.data()), submesh.meshlets.size_bytes());
+            if (!file.good())
+                return false;
+        }
+        std::error_code ec;
+        std::filesystem::rename(temp_path, cache_path, ec);
+        return !ec;
+    }
+}
+
+std::filesystem::path meshCachePath(const std::filesystem::path& source)
+{
+    auto cache_path = source;
+    cache_path += MESH_CACHE_EXTENSION;
+    return cache_path;
+}
+
+bool loadMeshCached(const std::filesystem::path& source, CachedMesh& mesh, const OBJLoadSettings& settings,
+    const MeshOptimizeSettings& optimize, const MeshLodSettings& lod_settings)
+{
+    auto load_start = std::chrono::steady_clock::now();
+    auto cache_path = meshCachePath(source);
+
+    if (!open_cache(source, cache_path, mesh, settings, optimize, lod_settings)) {
+        std::cout << "Mesh cache missing or stale: " << cache_path.string() << '\n';
+
+        if (!loadOBJ(source, mesh.storage, settings))
+            return false;
+        for (auto& submesh : mesh.storage) {
+            optimizeMesh(submesh, optimize);
+            generateLods(submesh, lod_settings);
+
+            size_t full_detail = submesh.lods.empty() ? submesh.indices.size() : submesh.lods.front().index_count;
+            if (full_detail / 3 >= MESHLET_MIN_MESH_TRIANGLES)
+                submesh.meshlets = buildMeshlets(submesh.vertices, std::span<GLuint>(submesh.indices).first(full_detail));
+        }
+        mesh.submeshes.clear();
+        for (const auto& submesh : mesh.storage)
+            mesh.submeshes.push_back(CachedSubmesh{ submesh.name, submesh.vertices, submesh.indices, submesh.bounds, submesh.sphere, submesh.lods, submesh.meshlets });
+        mesh.from_cache = false;
+
+        if (!write_cache(source, cache_path, mesh, settings, optimize, lod_settings))
+            std::cerr << "Mesh cache can not be written: " << cache_path.string() << '\n';
+    }
+
+    std::chrono::duration<double, std::milli> load_time = std::chrono::steady_clock::now() - load_start;
+    std::cout << "Mesh " << (mesh.from_cache ? "loaded from cache (warm)" : "parsed from source (cold)") << ": "
+        << source.string() << " in " << load_time.count() << " ms\n";
+    return true;
+}
@@ -0,0 +1,368 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include "MeshOptimizer.hpp"
+
+namespace {
+	void compute_meshlet_bounds(Meshlet& meshlet, std::span<const Vertex> vertices, std::span<const GLuint> indices) {
+		auto triangles = indices.subspan(meshlet.first_index, meshlet.index_count);
+
+		AABB bounds;
+		for (GLuint index : triangles)
+			bounds.extend(vertices[index].position);
+		meshlet.center = bounds.center();
+		meshlet.radius = 0.0f;
+		for (GLuint index : triangles)
+			meshlet.radius = std::max(meshlet.radius, glm::length(vertices[index].position - meshlet.center));
+
+		// cone axis = average face normal, cutoff from the widest deviation
+		std::vector<glm::vec3> normals;
+		glm::vec3 axis(0.0f);
+		for (size_t t = 0; t < triangles.size(); t += 3) {
+			const glm::vec3& p0 = vertices[triangles[t + 0]].position;
+			glm::vec3 normal = glm::cross(vertices[triangles[t + 1]].position - p0, vertices[triangles[t + 2]].position - p0);
+			float length = glm::length(normal);
+			if (length == 0.0f)
+				continue;
+			normals.push_back(normal / length);
+			axis += normals.back();
+		}
+
+		meshlet.cone_axis = glm::vec3(0.0f);
+		meshlet.cone_cutoff = 1.0f; // never culled
+		float axis_length = glm::length(axis);
+		if (axis_length == 0.0f)
+			return;
+		meshlet.cone_axis = axis / axis_length;
+		float min_dot = 1.0f;
+		for (const auto& normal : normals)
+			min_dot = std::min(min_dot, glm::dot(normal, meshlet.cone_axis));
+		// cone wider than ~85 degrees half-angle is not worth testing
+		if (min_dot > 0.1f)
+			meshlet.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+	}
+}
+
+VertexCacheStats analyzeVertexCache(std::span<const GLuint> indices, size_t vertex_count, unsigned int cache_size)
+{
+	VertexCacheStats stats;
+	if (indices.empty() || vertex_count == 0)
+		return stats;
+
+	// vertex is in FIFO cache, if it was inserted less than cache_size insertions ago
+	std::vector<uint32_t> insert_time(vertex_count, 0);
+	uint32_t time = cache_size + 1;
+	size_t misses = 0;
+	for (GLuint index : indices) {
+		if (time - insert_time[index] > cache_size) {
+			insert_time[index] = time++;
+			misses++;
+		}
+	}
+
+	stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+	stats.atvr = static_cast<float>(misses) / static_cast<float>(vertex_count);
+	return stats;
+}
+
+std::vector<size_t> optimizeVertexCache(std::vector<GLuint>& indices, size_t vertex_count, unsigned int cache_size)
+{
+	std::vector<size_t> clusters;
+	size_t triangle_count = indices.size() / 3;
+	if (triangle_count == 0)
+		return clusters;
+	clusters.push_back(0);
+
+	// vertex -> triangles adjacency, live[v] = number of not yet emitted triangles using v
+	std::vector<uint32_t> live(vertex_count, 0);
+	for (GLuint index : indices)
+		live[index]++;
+	std::vector<uint32_t> offsets(vertex_count + 1, 0);
+	std::inclusive_scan(live.begin(), live.end(), offsets.begin() + 1);
+	std::vector<uint32_t> adjacency(indices.size());
+	{
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++)
+			adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<uint32_t> cache_time(vertex_count, 0);
+	std::vector<bool> emitted(triangle_count, false);
+	std::vector<GLuint> dead_end;
+	std::vector<GLuint> candidates;
+	std::vector<GLuint> output;
+	output.reserve(indices.size());
+
+	uint32_t time = cache_size + 1;
+	size_t cursor = 0; // next vertex to try when dead-end stack runs out
+	constexpr size_t none = std::numeric_limits<size_t>::max();
+	size_t fanning = indices[0];
+
+	while (fanning != none) {
+		// emit all remaining triangles around the fanning vertex
+		candidates.clear();
+		for (uint32_t a = offsets[fanning]; a < offsets[fanning + 1]; a++) {
+			uint32_t triangle = adjacency[a];
+			if (emitted[triangle])
+				continue;
+			for (size_t k = 0; k < 3; k++) {
+				GLuint v = indices[triangle * 3 + k];
+				output.push_back(v);
+				dead_end.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+				if (time - cache_time[v] > cache_size)
+					cache_time[v] = time++;
+			}
+			emitted[triangle] = true;
+		}
+
+		// next fanning vertex: one-ring candidate which stays in cache for all its remaining triangles, oldest first
+		fanning = none;
+		int64_t best_priority = -1;
+		for (GLuint v : candidates) {
+			if (live[v] == 0)
+				continue;
+			int64_t priority = 0;
+			if (time - cache_time[v] + 2 * live[v] <= cache_size)
+				priority = time - cache_time[v];
+			if (priority > best_priority) {
+				best_priority = priority;
+				fanning = v;
+			}
+		}
+
+		if (fanning == none) {
+			// dead-end: recently used vertices first, then any vertex with remaining triangles
+			while (!dead_end.empty() && fanning == none) {
+				GLuint v = dead_end.back();
+				dead_end.pop_back();
+				if (live[v] > 0)
+					fanning = v;
+			}
+			for (; cursor < vertex_count && fanning == none; cursor++) {
+				if (live[cursor] > 0)
+					fanning = cursor;
+			}
+			if (fanning != none && output.size() / 3 != clusters.back())
+				clusters.push_back(output.size() / 3);
+		}
+	}
+
+	indices = std::move(output);
+	return clusters;
+}
+
+void optimizeOverdraw(std::vector<GLuint>& indices, std::span<const Vertex> vertices, const std::vector<size_t>& clusters)
+{
+	size_t triangle_count = indices.size() / 3;
+	if (clusters.size() < 2)
+		return;
+
+	struct Cluster {
+		size_t first;
+		size_t count;
+		glm::vec3 centroid{ 0.0f };
+		glm::vec3 normal{ 0.0f };
+		float sort_key{ 0.0f };
+	};
+
+	// area weighted centroid and normal of each cluster and of the whole mesh
+	std::vector<Cluster> parts;
+	glm::vec3 mesh_centroid(0.0f);
+	float mesh_area = 0.0f;
+	for (size_t c = 0; c < clusters.size(); c++) {
+		Cluster part{ clusters[c], (c + 1 < clusters.size() ? clusters[c + 1] : triangle_count) - clusters[c] };
+		float area = 0.0f;
+		for (size_t t = part.first; t < part.first + part.count; t++) {
+			const glm::vec3& p0 = vertices[indices[t * 3 + 0]].position;
+			const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+			const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0); // length = 2 * area
+			float weight = glm::length(normal);
+			part.normal += normal;
+			part.centroid += (p0 + p1 + p2) * (weight / 3.0f);
+			area += weight;
+		}
+		mesh_centroid += part.centroid;
+		mesh_area += area;
+		if (area > 0.0f)
+			part.centroid = part.centroid / area;
+		parts.push_back(part);
+	}
+	if (mesh_area > 0.0f)
+		mesh_centroid = mesh_centroid / mesh_area;
+
+	// clusters on the outside facing outwards occlude the rest of the mesh from most directions
+	for (auto& part : parts) {
+		float normal_length = glm::length(part.normal);
+		if (normal_length > 0.0f)
+			part.sort_key = glm::dot(part.centroid - mesh_centroid, part.normal / normal_length);
+	}
+	std::stable_sort(parts.begin(), parts.end(), [](const Cluster& a, const Cluster& b) { return a.sort_key > b.sort_key; });
+
+	std::vector<GLuint> output;
+	output.reserve(indices.size());
+	for (const auto& part : parts)
+		output.insert(output.end(), indices.begin() + part.first * 3, indices.begin() + (part.first + part.count) * 3);
+	indices = std::move(output);
+}
+
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<GLuint>& indices)
+{
+	constexpr GLuint unused = std::numeric_limits<GLuint>::max();
+	std::vector<GLuint> remap(vertices.size(), unused);
+	std::vector<Vertex> output;
+	output.reserve(vertices.size());
+
+	for (GLuint& index : indices) {
+		if (remap[index] == unused) {
+			remap[index] = static_cast<GLuint>(output.size());
+			output.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+	vertices = std::move(output);
+}
+
+std::vector<Meshlet> buildMeshlets(std::span<const Vertex> vertices, std::span<GLuint> indices, size_t max_vertices, size_t max_triangles)
+{
+	std::vector<Meshlet> meshlets;
+	size_t triangle_count = indices.size() / 3;
+	if (triangle_count == 0)
+		return meshlets;
+
+	std::vector<glm::vec3> face_normals(triangle_count, glm::vec3(0.0f));
+	for (size_t t = 0; t < triangle_count; t++) {
+		const glm::vec3& p0 = vertices[indices[t * 3]].position;
+		glm::vec3 normal = glm::cross(vertices[indices[t * 3 + 1]].position - p0, vertices[indices[t * 3 + 2]].position - p0);
+		float length = glm::length(normal);
+		if (length > 0.0f)
+			face_normals[t] = normal / length;
+	}
+
+	// vertex -> triangles
+	std::vector<uint32_t> offsets(vertices.size() + 1, 0);
+	for (GLuint index : indices.first(triangle_count * 3))
+		offsets[index + 1]++;
+	std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+	std::vector<uint32_t> adjacency(triangle_count * 3);
+	{
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < triangle_count * 3; i++)
+			adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+	}
+
+	std::vector<bool> emitted(triangle_count, false);
+	std::vector<uint32_t> owner(vertices.size(), 0); // 1 + index of the last meshlet using the vertex
+	std::vector<uint32_t> listed(triangle_count, 0); // 1 + index of the last meshlet having the triangle as candidate
+	std::vector<uint32_t> candidates;
+	constexpr size_t max_scanned = 512; // newest candidates only, bounds the cost on meshes with extreme valence
+	std::vector<GLuint> output;
+	output.reserve(triangle_count * 3);
+	size_t seed = 0; // triangles are seeded in their current (cache optimized) order
+
+	auto new_vertices = [&](uint32_t triangle, uint32_t id) {
+		size_t count = 0;
+		for (size_t k = 0; k < 3; k++) {
+			GLuint v = indices[triangle * 3 + k];
+			count += owner[v] != id && (k < 1 || v != indices[triangle * 3]) && (k < 2 || v != indices[triangle * 3 + 1]);
+		}
+		return count;
+	};
+
+	// Grow meshlets over shared vertices. Triangles adding fewest vertices go first,
+	// ties are broken by the normal closest to the meshlet average, which keeps normal cones narrow.
+	while (output.size() < triangle_count * 3) {
+		while (emitted[seed])
+			seed++;
+		uint32_t id = static_cast<uint32_t>(meshlets.size() + 1);
+		Meshlet meshlet{};
+		meshlet.first_index = static_cast<uint32_t>(output.size());
+		size_t meshlet_vertices = 0;
+		glm::vec3 normal_sum(0.0f);
+		candidates.clear();
+
+		uint32_t next = static_cast<uint32_t>(seed);
+		while (true) {
+			meshlet_vertices += new_vertices(next, id);
+			emitted[next] = true;
+			normal_sum += face_normals[next];
+			meshlet.index_count += 3;
+			for (size_t k = 0; k < 3; k++) {
+				GLuint v = indices[next * 3 + k];
+				output.push_back(v);
+				owner[v] = id;
+				for (uint32_t a = offsets[v]; a < offsets[v + 1]; a++) {
+					uint32_t triangle = adjacency[a];
+					if (!emitted[triangle] && listed[triangle] != id) {
+						listed[triangle] = id;
+						candidates.push_back(triangle);
+					}
+				}
+			}
+			if (meshlet.index_count / 3 == max_triangles)
+				break;
+
+			// pick the best candidate, drop the emitted ones
+			int64_t best = -1;
+			size_t best_new = 4;
+			float best_dot = -2.0f;
+			size_t kept = candidates.size() > max_scanned ? candidates.size() - max_scanned : 0;
+			for (size_t i = kept; i < candidates.size(); i++) {
+				uint32_t triangle = candidates[i];
+				if (emitted[triangle])
+					continue;
+				candidates[kept++] = triangle;
+				size_t added = new_vertices(triangle, id);
+				if (meshlet_vertices + added > max_vertices)
+					continue;
+				float alignment = glm::dot(face_normals[triangle], normal_sum);
+				if (added < best_new || (added == best_new && alignment > best_dot)) {
+					best = triangle;
+					best_new = added;
+					best_dot = alignment;
+				}
+			}
+			candidates.resize(kept);
+			if (best < 0)
+				break;
+			next = static_cast<uint32_t>(best);
+		}
+		meshlets.push_back(meshlet);
+	}
+
+	std::copy(output.begin(), output.end(), indices.begin());
+	for (auto& meshlet : meshlets)
+		compute_meshlet_bounds(meshlet, vertices, indices);
+	return meshlets;
+}
+
+void optimizeMesh(SubmeshData& submesh, const MeshOptimizeSettings& settings)
+{
+	if (!settings.enabled() || submesh.indices.size() < 3)
+		return;
+
+	auto start = std::chrono::steady_clock::now();
+	auto before = analyzeVertexCache(submesh.indices, submesh.vertices.size(), settings.cache_size);
+
+	std::vector<size_t> clusters;
+	if (settings.vertex_cache)
+		clusters = optimizeVertexCache(submesh.indices, submesh.vertices.size(), settings.cache_size);
+	if (settings.overdraw)
+		optimizeOverdraw(submesh.indices, submesh.vertices, clusters);
+	if (settings.vertex_fetch)
+		optimizeVertexFetch(submesh.vertices, submesh.indices);
+
+	auto after = analyzeVertexCache(submesh.indices, submesh.vertices.size(), settings.cache_size);
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+
+	std::cout << "Mesh optimized: " << submesh.name
+		<< " ACMR " << before.acmr << " -> " << after.acmr
+		<< ", ATVR " << before.atvr << " -> " << after.atvr
+		<< " (" << clusters.size() << " clusters, " << time.count() << " ms)\n";
+}
@@ -0,0 +1,262 @@
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <unordered_map>
+
+#include "MeshSimplifier.hpp"
+#include "MeshOptimizer.hpp"
+
+namespace {
+	// symmetric error quadric, error(p) = p^T A p + 2 b^T p + c, summed over planes weighted by triangle area
+	struct Quadric {
+		double a00{ 0 }, a01{ 0 }, a02{ 0 }, a11{ 0 }, a12{ 0 }, a22{ 0 };
+		double b0{ 0 }, b1{ 0 }, b2{ 0 };
+		double c{ 0 };
+		double weight{ 0 };
+
+		void add_plane(const glm::vec3& n, double d, double w) {
+			a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z;
+			a11 += w * n.y * n.y; a12 += w * n.y * n.z; a22 += w * n.z * n.z;
+			b0 += w * n.x * d; b1 += w * n.y * d; b2 += w * n.z * d;
+			c += w * d * d;
+			weight += w;
+		}
+
+		Quadric& operator += (const Quadric& q) {
+			a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+			b0 += q.b0; b1 += q.b1; b2 += q.b2;
+			c += q.c;
+			weight += q.weight;
+			return *this;
+		}
+
+		// mean squared distance of p from the planes
+		float error(const glm::vec3& p) const {
+			double x = p.x, y = p.y, z = p.z;
+			double e = a00 * x * x + a11 * y * y + a22 * z * z + 2 * (a01 * x * y + a02 * x * z + a12 * y * z)
+				+ 2 * (b0 * x + b1 * y + b2 * z) + c;
+			return weight > 0 ? static_cast<float>(std::max(e, 0.0) / weight) : 0.0f;
+		}
+	};
+
+	struct Collapse {
+		GLuint from;
+		GLuint to;
+		float cost;
+	};
+}
+
+std::vector<GLuint> simplifyMesh(std::span<const Vertex> vertices, std::span<const GLuint> indices,
+	size_t target_index_count, float max_error, float* result_error)
+{
+	std::vector<GLuint> result(indices.begin(), indices.end());
+	if (result_error)
+		*result_error = 0.0f;
+	if (result.size() <= target_index_count || vertices.empty())
+		return result;
+
+	// work in unit-sized space, so that errors are relative to mesh size
+	size_t vertex_count = vertices.size();
+	AABB bounds = AABB::of(vertices);
+	glm::vec3 size = bounds.max_point - bounds.min_point;
+	float scale = std::max({ size.x, size.y, size.z });
+	if (scale <= 0.0f)
+		return result;
+	std::vector<glm::vec3> positions(vertex_count);
+	for (size_t i = 0; i < vertex_count; i++)
+		positions[i] = (vertices[i].position - bounds.min_point) / scale;
+
+	// vertices at the same position share one id (lowest index), geometry is simplified per position
+	std::vector<GLuint> order(vertex_count);
+	std::iota(order.begin(), order.end(), 0);
+	auto position_less = [&](GLuint a, GLuint b) {
+		const auto& pa = positions[a];
+		const auto& pb = positions[b];
+		return pa.x < pb.x || (pa.x == pb.x && (pa.y < pb.y || (pa.y == pb.y && pa.z < pb.z)));
+	};
+	std::sort(order.begin(), order.end(), position_less);
+
+	std::vector<GLuint> position_id(vertex_count);
+	std::vector<bool> locked(vertex_count, false); // by position id
+	for (size_t i = 0; i < vertex_count;) {
+		size_t j = i + 1;
+		while (j < vertex_count && !position_less(order[i], order[j]))
+			j++;
+		GLuint id = *std::min_element(order.begin() + i, order.begin() + j);
+		for (size_t k = i; k < j; k++)
+			position_id[order[k]] = id;
+		// attribute seam, collapsing would tear the attributes apart
+		if (j - i > 1)
+			locked[id] = true;
+		i = j;
+	}
+
+	// borders and non-manifold edges (not shared by exactly two triangles) keep the outline
+	auto edge_key = [&](GLuint a, GLuint b) {
+		uint64_t pa = position_id[a], pb = position_id[b];
+		return pa < pb ? (pa << 32 | pb) : (pb << 32 | pa);
+	};
+	std::unordered_map<uint64_t, uint32_t> edge_use;
+	for (size_t i = 0; i < result.size(); i += 3)
+		for (size_t k = 0; k < 3; k++)
+			edge_use[edge_key(result[i + k], result[i + (k + 1) % 3])]++;
+	for (size_t i = 0; i < result.size(); i += 3)
+		for (size_t k = 0; k < 3; k++) {
+			GLuint a = result[i + k], b = result[i + (k + 1) % 3];
+			if (edge_use[edge_key(a, b)] != 2)
+				locked[position_id[a]] = locked[position_id[b]] = true;
+		}
+
+	std::vector<Quadric> quadrics(vertex_count); // by position id
+	for (size_t i = 0; i < result.size(); i += 3) {
+		const glm::vec3& p0 = positions[result[i + 0]];
+		glm::vec3 normal = glm::cross(positions[result[i + 1]] - p0, positions[result[i + 2]] - p0);
+		float length = glm::length(normal);
+		if (length == 0.0f)
+			continue;
+		normal = normal / length;
+		for (size_t k = 0; k < 3; k++)
+			quadrics[position_id[result[i + k]]].add_plane(normal, -glm::dot(normal, p0), length * 0.5);
+	}
+
+	std::vector<Collapse> collapses;
+	std::vector<GLuint> remap(vertex_count);
+	std::vector<bool> touched(vertex_count);
+	std::vector<uint32_t> offsets(vertex_count + 1);
+	std::vector<uint32_t> adjacency;
+	float max_cost = max_error * max_error;
+	float worst_cost = 0.0f;
+
+	// Each pass collapses cheapest edges whose neighbourhoods do not overlap, then rebuilds the index buffer.
+	while (result.size() > target_index_count) {
+		size_t triangle_count = result.size() / 3;
+
+		collapses.clear();
+		for (size_t i = 0; i < result.size(); i += 3)
+			for (size_t k = 0; k < 3; k++) {
+				GLuint a = result[i + k], b = result[i + (k + 1) % 3];
+				for (auto [from, to] : { std::pair{ a, b }, std::pair{ b, a } }) {
+					if (locked[position_id[from]] || position_id[from] == position_id[to])
+						continue;
+					Quadric q = quadrics[position_id[from]];
+					q += quadrics[position_id[to]];
+					collapses.push_back(Collapse{ from, to, q.error(positions[to]) });
+				}
+			}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+		// vertex -> triangles
+		std::fill(offsets.begin(), offsets.end(), 0);
+		for (GLuint index : result)
+			offsets[index + 1]++;
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+		adjacency.resize(result.size());
+		{
+			std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+			for (size_t i = 0; i < result.size(); i++)
+				adjacency[fill[result[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		// moving "from" to "to" must not flip or heavily rotate any remaining triangle
+		auto flips = [&](GLuint from, GLuint to) {
+			for (uint32_t a = offsets[from]; a < offsets[from + 1]; a++) {
+				const GLuint* triangle = &result[adjacency[a] * 3];
+				if (position_id[triangle[0]] == position_id[to] || position_id[triangle[1]] == position_id[to] || position_id[triangle[2]] == position_id[to])
+					continue; // removed by the collapse
+				glm::vec3 p[3], q[3];
+				for (size_t k = 0; k < 3; k++) {
+					p[k] = positions[triangle[k]];
+					q[k] = triangle[k] == from ? positions[to] : p[k];
+				}
+				glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+				glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+				if (glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after))
+					return true;
+			}
+			return false;
+		};
+
+		std::iota(remap.begin(), remap.end(), 0);
+		std::fill(touched.begin(), touched.end(), false);
+		size_t removable = triangle_count - target_index_count / 3;
+		size_t removed = 0;
+		size_t collapsed = 0;
+		for (const auto& collapse : collapses) {
+			if (collapse.cost > max_cost || removed >= removable)
+				break;
+			if (touched[collapse.from] || touched[collapse.to] || flips(collapse.from, collapse.to))
+				continue;
+
+			// neighbourhood changes, its adjacency is not valid until the next pass
+			for (uint32_t a = offsets[collapse.from]; a < offsets[collapse.from + 1]; a++) {
+				const GLuint* triangle = &result[adjacency[a] * 3];
+				bool degenerate = false;
+				for (size_t k = 0; k < 3; k++) {
+					touched[triangle[k]] = true;
+					degenerate |= position_id[triangle[k]] == position_id[collapse.to];
+				}
+				removed += degenerate;
+			}
+			remap[collapse.from] = collapse.to;
+			quadrics[position_id[collapse.to]] += quadrics[position_id[collapse.from]];
+			worst_cost = std::max(worst_cost, collapse.cost);
+			collapsed++;
+		}
+		if (collapsed == 0)
+			break;
+
+		size_t out = 0;
+		for (size_t i = 0; i < result.size(); i += 3) {
+			GLuint a = remap[result[i + 0]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+			if (position_id[a] == position_id[b] || position_id[b] == position_id[c] || position_id[a] == position_id[c])
+				continue;
+			result[out++] = a;
+			result[out++] = b;
+			result[out++] = c;
+		}
+		result.resize(out);
+	}
+
+	if (result_error)
+		*result_error = std::sqrt(worst_cost);
+	return result;
+}
+
+void generateLods(SubmeshData& submesh, const MeshLodSettings& settings)
+{
+	submesh.lods.clear();
+	if (!settings.enabled() || submesh.indices.size() < 3)
+		return;
+
+	auto start = std::chrono::steady_clock::now();
+	submesh.lods.push_back(MeshLod{ 0, static_cast<uint32_t>(submesh.indices.size()), 0.0f });
+
+	// every level is simplified from the previous one, errors add up
+	std::vector<GLuint> previous(submesh.indices);
+	double target = static_cast<double>(previous.size());
+	for (unsigned int level = 1; level < settings.count; level++) {
+		target *= settings.reduction;
+		size_t target_count = static_cast<size_t>(target) / 3 * 3;
+
+		float error = 0.0f;
+		auto lod = simplifyMesh(submesh.vertices, previous, target_count, settings.max_error, &error);
+		if (lod.empty() || lod.size() > previous.size() * 9 / 10)
+			break;
+
+		optimizeVertexCache(lod, submesh.vertices.size());
+		submesh.lods.push_back(MeshLod{ static_cast<uint32_t>(submesh.indices.size()), static_cast<uint32_t>(lod.size()), submesh.lods.back().error + error });
+		submesh.indices.insert(submesh.indices.end(), lod.begin(), lod.end());
+		previous = std::move(lod);
+	}
+
+	std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+	std::cout << "Mesh LODs: " << submesh.name << " triangles";
+	for (const auto& lod : submesh.lods)
+		std::cout << ' ' << lod.index_count / 3;
+	std::cout << " (" << time.count() << " ms)\n";
+
+	if (submesh.lods.size() == 1)
+		submesh.lods.clear();
+}
@@ -1,93 +1,572 @@
 #include <string>
+#include <string_view>
+#include <charconv>
 #include <algorithm>
-#include <GL/glew.h> 
+#include <unordered_map>
+#include <chrono>
+#include <cmath>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <iostream>
+#include <thread>
+#include <deque>
 
 #include "ObjectLoader.hpp"
+#include "JobSystem.hpp"
+#include "MappedFile.hpp"
 
-#define MAX_LINE_SIZE 1024
+namespace {
+	inline void hash_combine(size_t& seed, size_t value) {
+		seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+	}
 
-bool loadOBJ(const std::filesystem::path& filename, std::vector<Vertex>& vertices, std::vector<GLuint>& indices)
-{
-	std::cout << "Loading model: " << filename.string() << std::endl;
+	// +0.0f and -0.0f compare equal, so they must hash equal too
+	inline size_t hash_float(float f) {
+		return f == 0.0f ? 0 : std::bit_cast<uint32_t>(f);
+	}
 
-	std::vector<glm::vec3> temp_vertices;
-	std::vector<glm::vec2> temp_uvs;
-	std::vector<glm::vec3> temp_normals;
+	// face corner as (v, vt, vn) indices, 1-based as in the file, 0 = not present
+	struct CornerKey {
+		unsigned int v, vt, vn;
+		bool operator == (const CornerKey&) const = default;
+	};
 
-	vertices.clear();
-	indices.clear();
+	struct CornerKeyHash {
+		size_t operator()(const CornerKey& k) const noexcept {
+			size_t seed = k.v;
+			hash_combine(seed, k.vt);
+			hash_combine(seed, k.vn);
+			return seed;
+		}
+	};
 
-	FILE* file = nullptr;
-	fopen_s(&file, filename.string().c_str(), "r");
-	if (file == NULL) {
-		printf("Impossible to open the file !\n");
-		return false;
-	}
+	// consistent with Vertex::operator ==
+	struct VertexHash {
+		size_t operator()(const Vertex& v) const noexcept {
+			size_t seed = hash_float(v.position.x);
+			hash_combine(seed, hash_float(v.position.y));
+			hash_combine(seed, hash_float(v.position.z));
+			hash_combine(seed, hash_float(v.normal.x));
+			hash_combine(seed, hash_float(v.normal.y));
+			hash_combine(seed, hash_float(v.normal.z));
+			hash_combine(seed, hash_float(v.texCoords.x));
+			hash_combine(seed, hash_float(v.texCoords.y));
+			return seed;
+		}
+	};
+
+	// cell of uniform grid with cell size = weld epsilon
+	struct CellKey {
+		int64_t x, y, z;
+		bool operator == (const CellKey&) const = default;
+	};
+
+	struct CellKeyHash {
+		size_t operator()(const CellKey& k) const noexcept {
+			size_t seed = static_cast<size_t>(k.x);
+			hash_combine(seed, static_cast<size_t>(k.y));
+			hash_combine(seed, static_cast<size_t>(k.z));
+			return seed;
+		}
+	};
+
+	// Removes duplicate vertices in (expected) linear time.
+	// Every corner is looked up by its (v, vt, vn) triple first, so each distinct triple is resolved only once.
+	// A new triple is then matched by value - exactly (same result as linear search over all vertices),
+	// or within epsilon using uniform grid of positions.
+	class VertexWelder {
+	public:
+		VertexWelder(std::vector<Vertex>& vertices, float epsilon) : vertices_{ vertices }, epsilon_{ epsilon } {}
+
+		template <typename MakeVertex>
+		GLuint weld(const CornerKey& key, MakeVertex make_vertex) {
+			auto corner = corner_map_.find(key);
+			if (corner != corner_map_.end())
+				return corner->second;
 
-	while (1) {
+			Vertex vertex = make_vertex();
+			GLuint index = (epsilon_ > 0.0f) ? weld_nearby(vertex) : weld_exact(vertex);
+			corner_map_.emplace(key, index);
+			return index;
+		}
+
+	private:
+		std::vector<Vertex>& vertices_;
+		float epsilon_;
 
-		char lineHeader[MAX_LINE_SIZE];
-		int res = fscanf_s(file, "%s", lineHeader, MAX_LINE_SIZE);
-		if (res == EOF) {
-			break;
+		std::unordered_map<CornerKey, GLuint, CornerKeyHash> corner_map_;
+		std::unordered_map<Vertex, GLuint, VertexHash> vertex_map_;
+		std::unordered_map<CellKey, std::vector<GLuint>, CellKeyHash> cell_map_;
+
+		GLuint append(const Vertex& vertex) {
+			vertices_.push_back(vertex);
+			return static_cast<GLuint>(vertices_.size() - 1);
 		}
 
-		if (strcmp(lineHeader, "v") == 0) {
-			glm::vec3 vertex;
-			fscanf_s(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z);
-			temp_vertices.push_back(vertex);
+		GLuint weld_exact(const Vertex& vertex) {
+			auto found = vertex_map_.find(vertex);
+			if (found != vertex_map_.end())
+				return found->second;
+
+			GLuint index = append(vertex);
+			vertex_map_.emplace(vertex, index);
+			return index;
 		}
-		else if (strcmp(lineHeader, "vt") == 0) {
-			glm::vec2 uv;
-			fscanf_s(file, "%f %f\n", &uv.x, &uv.y);
-			temp_uvs.push_back(uv);
+
+		bool is_within(const Vertex& a, const Vertex& b) const {
+			auto within = [this](float x, float y) { return std::abs(x - y) <= epsilon_; };
+			return within(a.position.x, b.position.x) && within(a.position.y, b.position.y) && within(a.position.z, b.position.z)
+				&& within(a.normal.x, b.normal.x) && within(a.normal.y, b.normal.y) && within(a.normal.z, b.normal.z)
+				&& within(a.texCoords.x, b.texCoords.x) && within(a.texCoords.y, b.texCoords.y);
 		}
-		else if (strcmp(lineHeader, "vn") == 0) {
-			glm::vec3 normal;
-			fscanf_s(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z);
-			temp_normals.push_back(normal);
+
+		GLuint weld_nearby(const Vertex& vertex) {
+			CellKey cell{
+				static_cast<int64_t>(std::floor(vertex.position.x / epsilon_)),
+				static_cast<int64_t>(std::floor(vertex.position.y / epsilon_)),
+				static_cast<int64_t>(std::floor(vertex.position.z / epsilon_)) };
+
+			// candidate within epsilon can be only in the same or directly neighbouring cell,
+			// take the oldest one to keep the result independent of hash map ordering
+			GLuint best = std::numeric_limits<GLuint>::max();
+			for (int64_t dx = -1; dx <= 1; dx++) {
+				for (int64_t dy = -1; dy <= 1; dy++) {
+					for (int64_t dz = -1; dz <= 1; dz++) {
+						auto found = cell_map_.find(CellKey{ cell.x + dx, cell.y + dy, cell.z + dz });
+						if (found == cell_map_.end())
+							continue;
+						for (GLuint candidate : found->second) {
+							if (candidate < best && is_within(vertex, vertices_[candidate]))
+								best = candidate;
+						}
+					}
+				}
+			}
+			if (best != std::numeric_limits<GLuint>::max())
+				return best;
+
+			GLuint index = append(vertex);
+			cell_map_[cell].push_back(index);
+			return index;
 		}
-		else if (strcmp(lineHeader, "f") == 0) {
-			std::string vertex1, vertex2, vertex3;
-			unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
-			int matches = fscanf_s(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2]);
-			if (matches != 9) {
-				printf("File can't be read by simple parser :( Try exporting with other options\n");
+	};
+
+	// Minimal scanner over raw bytes of the file (no locale, no allocations).
+	// All functions stop at the end of the current line.
+	inline bool is_blank(char c) {
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	inline void skip_blanks(const char*& p, const char* end) {
+		while (p < end && is_blank(*p))
+			p++;
+	}
+
+	inline void skip_line(const char*& p, const char* end) {
+		while (p < end && *p != '\n')
+			p++;
+		if (p < end)
+			p++;
+	}
+
+	inline std::string_view read_token(const char*& p, const char* end) {
+		skip_blanks(p, end);
+		const char* begin = p;
+		while (p < end && !is_blank(*p) && *p != '\n')
+			p++;
+		return std::string_view(begin, p - begin);
+	}
+
+	inline bool read_float(const char*& p, const char* end, float& value) {
+		skip_blanks(p, end);
+		if (p < end && *p == '+') // from_chars does not accept explicit plus sign
+			p++;
+		// std::from_chars is locale independent and correctly rounded, i.e. same result as scanf("%f")
+		auto [ptr, ec] = std::from_chars(p, end, value);
+		if (ec != std::errc())
+			return false;
+		p = ptr;
+		return true;
+	}
+
+	inline bool read_int(const char*& p, const char* end, long& value) {
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+')) {
+			negative = (*p == '-');
+			p++;
+		}
+		if (p >= end || *p < '0' || *p > '9')
+			return false;
+
+		long result = 0;
+		while (p < end && *p >= '0' && *p <= '9') {
+			result = result * 10 + (*p - '0');
+			p++;
+		}
+		value = negative ? -result : result;
+		return true;
+	}
+
+	// Face corner as written in the file. Negative (relative) indices are resolved to index
+	// relative to the start of parsed text, made absolute once the preceding counts are known.
+	struct RawCorner {
+		int32_t index[3]; // v, vt, vn
+		uint32_t relative; // bit mask of relative indices
+	};
+
+	// "v", "v/vt", "v//vn" or "v/vt/vn"
+	inline bool read_corner(const char*& p, const char* end, const size_t counts[3], RawCorner& corner) {
+		corner = RawCorner{ { 0, 0, 0 }, 0 };
+		for (int i = 0; i < 3; i++) {
+			if (i > 0) {
+				if (p >= end || *p != '/')
+					break;
+				p++;
+				if (i == 1 && p < end && *p == '/') // empty texture coords "v//vn"
+					continue;
+			}
+			long value;
+			if (!read_int(p, end, value) || value == 0)
 				return false;
+			if (value < 0) {
+				corner.index[i] = static_cast<int32_t>(static_cast<long>(counts[i]) + value);
+				corner.relative |= 1u << i;
+			}
+			else {
+				corner.index[i] = static_cast<int32_t>(value);
 			}
+		}
+		return p >= end || is_blank(*p) || *p == '\n';
+	}
+
+	// o, g and usemtl statements change the submesh of all following faces
+	struct GroupMarker {
+		enum class Kind { object, group, material } kind;
+		std::string name;
+		size_t first_corner; // first corner affected
+	};
+
+	// raw content of OBJ file (or its part)
+	struct OBJRecords {
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec2> uvs;
+		std::vector<glm::vec3> normals;
+		std::vector<RawCorner> corners; // 3 corners per triangle
+		std::vector<GroupMarker> groups;
+	};
+
+	bool parse_obj(std::string_view text, OBJRecords& records) {
+		const char* p = text.data();
+		const char* end = p + text.size();
 
-			for (int i = 0; i < 3; i++) {
-				GLuint currentIndex;
-				Vertex currentVertex;
-				currentVertex.position = temp_vertices[vertexIndex[i] - 1]; // OBJ array start from 1
-				currentVertex.normal = temp_normals[normalIndex[i] - 1];
-				currentVertex.texCoords = temp_uvs[uvIndex[i] - 1];
-
-				// avoid duplicit vertices
-				auto t = std::find_if(vertices.begin(),
-					vertices.end(),
-					[&currentVertex]
-					(const Vertex& v2) -> bool {
-						return (currentVertex == v2);
-					});
-
-				if (t == vertices.end()) {
-					vertices.push_back(currentVertex);
-					currentIndex = vertices.size() - 1;
+		std::vector<RawCorner> face;
+
+		while (p < end) {
+			std::string_view keyword = read_token(p, end);
+
+			if (keyword == "v") {
+				glm::vec3 vertex;
+				if (!read_float(p, end, vertex.x) || !read_float(p, end, vertex.y) || !read_float(p, end, vertex.z))
+					return false;
+				records.positions.push_back(vertex);
+			}
+			else if (keyword == "vt") {
+				glm::vec2 uv;
+				if (!read_float(p, end, uv.x) || !read_float(p, end, uv.y))
+					return false;
+				records.uvs.push_back(uv);
+			}
+			else if (keyword == "vn") {
+				glm::vec3 normal;
+				if (!read_float(p, end, normal.x) || !read_float(p, end, normal.y) || !read_float(p, end, normal.z))
+					return false;
+				records.normals.push_back(normal);
+			}
+			else if (keyword == "f") {
+				const size_t counts[3] = { records.positions.size(), records.uvs.size(), records.normals.size() };
+				face.clear();
+				for (skip_blanks(p, end); p < end && *p != '\n'; skip_blanks(p, end)) {
+					RawCorner corner;
+					if (!read_corner(p, end, counts, corner)) {
+						std::cerr << "Unsupported face format\n";
+						return false;
+					}
+					face.push_back(corner);
 				}
-				else {
-					currentIndex = t - vertices.begin();
+				if (face.size() < 3) {
+					std::cerr << "Face with less than 3 corners\n";
+					return false;
 				}
-				indices.push_back(currentIndex);
+				// triangulate as a fan, fine for convex polygons
+				for (size_t i = 1; i + 1 < face.size(); i++) {
+					records.corners.push_back(face[0]);
+					records.corners.push_back(face[i]);
+					records.corners.push_back(face[i + 1]);
+				}
+			}
+			else if (keyword == "o" || keyword == "g" || keyword == "usemtl") {
+				auto kind = (keyword == "o") ? GroupMarker::Kind::object : (keyword == "g") ? GroupMarker::Kind::group : GroupMarker::Kind::material;
+				skip_blanks(p, end);
+				const char* name_begin = p;
+				while (p < end && *p != '\n' && *p != '\r')
+					p++;
+				records.groups.push_back(GroupMarker{ kind, std::string(name_begin, p - name_begin), records.corners.size() });
 			}
+			// comments, empty lines and unsupported keywords are skipped
+			skip_line(p, end);
+		}
+		return true;
+	}
 
+	// task(i) for every chunk, concurrently
+	template <typename Task>
+	void run_chunks(size_t count, JobSystem* jobs, Task&& task) {
+		if (jobs) {
+			jobs->parallelFor(count, 1, [&](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++)
+					task(i);
+				});
+			return;
 		}
+		std::vector<std::thread> workers;
+		for (size_t i = 0; i < count; i++)
+			workers.emplace_back([&, i]() { task(i); });
+		for (auto& worker : workers)
+			worker.join();
 	}
 
-	std::cout << "Model loaded: " << filename.string() << std::endl;
+	// Splits the text into chunks at line boundaries, parses chunks concurrently and merges
+	// per-chunk records in file order. Offset of each chunk in the merged arrays is exclusive
+	// prefix sum of the counts of all preceding chunks, so the result equals serial parse_obj().
+	bool parse_obj_parallel(std::string_view text, OBJRecords& records, unsigned int thread_count, JobSystem* jobs) {
+		std::vector<std::string_view> chunks;
+		size_t chunk_size = text.size() / thread_count + 1;
+		size_t chunk_begin = 0;
+		while (chunk_begin < text.size()) {
+			// move chunk end behind the nearest newline, so no line is split
+			size_t chunk_end = text.find('\n', std::min(chunk_begin + chunk_size, text.size()) - 1);
+			chunk_end = (chunk_end == std::string_view::npos) ? text.size() : chunk_end + 1;
+			chunks.push_back(text.substr(chunk_begin, chunk_end - chunk_begin));
+			chunk_begin = chunk_end;
+		}
 
-	fclose(file);
+		std::vector<OBJRecords> chunk_records(chunks.size());
+		std::vector<char> chunk_ok(chunks.size(), false); // not vector<bool>, elements are written concurrently
+		run_chunks(chunks.size(), jobs, [&](size_t i) { chunk_ok[i] = parse_obj(chunks[i], chunk_records[i]); });
+		if (std::find(chunk_ok.begin(), chunk_ok.end(), false) != chunk_ok.end())
+			return false;
+
+		struct Offsets {
+			size_t positions, uvs, normals, corners;
+		};
+		std::vector<Offsets> offsets(chunks.size() + 1, Offsets{ 0, 0, 0, 0 });
+		for (size_t i = 0; i < chunks.size(); i++) {
+			offsets[i + 1].positions = offsets[i].positions + chunk_records[i].positions.size();
+			offsets[i + 1].uvs = offsets[i].uvs + chunk_records[i].uvs.size();
+			offsets[i + 1].normals = offsets[i].normals + chunk_records[i].normals.size();
+			offsets[i + 1].corners = offsets[i].corners + chunk_records[i].corners.size();
+		}
+
+		records.positions.resize(offsets.back().positions);
+		records.uvs.resize(offsets.back().uvs);
+		records.normals.resize(offsets.back().normals);
+		records.corners.resize(offsets.back().corners);
+		run_chunks(chunks.size(), jobs, [&](size_t i) {
+			const OBJRecords& chunk = chunk_records[i];
+			std::copy(chunk.positions.begin(), chunk.positions.end(), records.positions.begin() + offsets[i].positions);
+			std::copy(chunk.uvs.begin(), chunk.uvs.end(), records.uvs.begin() + offsets[i].uvs);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), records.normals.begin() + offsets[i].normals);
+
+			// relative indices were resolved against chunk start only
+			const size_t chunk_offsets[3] = { offsets[i].positions, offsets[i].uvs, offsets[i].normals };
+			auto out = records.corners.begin() + offsets[i].corners;
+			for (RawCorner corner : chunk.corners) {
+				for (int k = 0; k < 3; k++) {
+					if (corner.relative & (1u << k))
+						corner.index[k] += static_cast<int32_t>(chunk_offsets[k]);
+				}
+				*out++ = corner;
+			}
+			});
+
+		for (size_t i = 0; i < chunks.size(); i++) {
+			for (const auto& marker : chunk_records[i].groups)
+				records.groups.push_back(GroupMarker{ marker.kind, marker.name, marker.first_corner + offsets[i].corners });
+		}
+		return true;
+	}
+
+	// Builds submeshes from parsed records, corners are processed in file order.
+	bool build_submeshes(const OBJRecords& records, const OBJLoadSettings& settings, std::vector<SubmeshData>& submeshes) {
+		// deque keeps builders in place, welders hold reference to vertices of their submesh
+		struct SubmeshBuilder {
+			SubmeshData data;
+			VertexWelder welder;
+			std::vector<char> missing_normal; // per vertex
+
+			SubmeshBuilder(const std::string& name, float weld_epsilon) : data{}, welder{ data.vertices, weld_epsilon } { data.name = name; }
+		};
+		std::deque<SubmeshBuilder> builders;
+		std::unordered_map<std::string, size_t> submesh_by_name;
+
+		std::string object_name, group_name, material_name;
+		auto current_group = records.groups.begin();
+		size_t current_submesh = 0;
+		bool group_changed = true;
+
+		const size_t counts[3] = { records.positions.size(), records.uvs.size(), records.normals.size() };
+
+		for (size_t c = 0; c < records.corners.size(); c++) {
+			// switch submesh on group boundary (only between triangles)
+			while (current_group != records.groups.end() && current_group->first_corner <= c) {
+				switch (current_group->kind) {
+				case GroupMarker::Kind::object: object_name = current_group->name; break;
+				case GroupMarker::Kind::group: group_name = current_group->name; break;
+				case GroupMarker::Kind::material: material_name = current_group->name; break;
+				}
+				group_changed = true;
+				++current_group;
+			}
+			if (group_changed) {
+				group_changed = false;
+				std::string name;
+				if (settings.split_groups) {
+					for (const auto* part : { &object_name, &group_name, &material_name }) {
+						if (part->empty())
+							continue;
+						if (!name.empty())
+							name += '/';
+						name += *part;
+					}
+				}
+				auto [found, inserted] = submesh_by_name.try_emplace(name, builders.size());
+				if (inserted)
+					builders.emplace_back(name, settings.weld_epsilon);
+				current_submesh = found->second;
+			}
+
+			SubmeshBuilder& builder = builders[current_submesh];
+			SubmeshData& submesh = builder.data;
+
+			// make indices absolute, 1-based, 0 = not present
+			const RawCorner& raw = records.corners[c];
+			CornerKey key;
+			unsigned int* key_index[3] = { &key.v, &key.vt, &key.vn };
+			for (int k = 0; k < 3; k++) {
+				int64_t index = raw.index[k];
+				if (raw.relative & (1u << k))
+					index += 1; // was 0-based
+				if (index < 0 || static_cast<uint64_t>(index) > counts[k] || (k == 0 && index == 0)) {
+					std::cerr << "Index out of range\n";
+					return false;
+				}
+				*key_index[k] = static_cast<unsigned int>(index);
+			}
+
+			// avoid duplicit vertices
+			size_t vertex_count = submesh.vertices.size();
+			GLuint index = builder.welder.weld(key, [&]() {
+				Vertex vertex;
+				vertex.position = records.positions[key.v - 1]; // OBJ array start from 1
+				vertex.normal = key.vn ? records.normals[key.vn - 1] : glm::vec3(0.0f);
+				vertex.texCoords = key.vt ? records.uvs[key.vt - 1] : glm::vec2(0.0f);
+				return vertex;
+				});
+			if (submesh.vertices.size() > vertex_count)
+				builder.missing_normal.push_back(key.vn == 0);
+			submesh.indices.push_back(index);
+		}
+
+		for (auto& builder : builders) {
+			SubmeshData& submesh = builder.data;
+			const auto& missing_normal = builder.missing_normal;
+
+			// smooth normals for vertices without normal: area weighted sum of adjacent face normals
+			if (std::find(missing_normal.begin(), missing_normal.end(), true) != missing_normal.end()) {
+				for (size_t t = 0; t + 2 < submesh.indices.size(); t += 3) {
+					GLuint a = submesh.indices[t], b = submesh.indices[t + 1], c = submesh.indices[t + 2];
+					glm::vec3 face_normal = glm::cross(submesh.vertices[b].position - submesh.vertices[a].position,
+						submesh.vertices[c].position - submesh.vertices[a].position);
+					for (GLuint v : { a, b, c }) {
+						if (missing_normal[v])
+							submesh.vertices[v].normal += face_normal;
+					}
+				}
+				for (size_t v = 0; v < submesh.vertices.size(); v++) {
+					if (missing_normal[v] && glm::length(submesh.vertices[v].normal) > 0.0f)
+						submesh.vertices[v].normal = glm::normalize(submesh.vertices[v].normal);
+				}
+			}
+
+			submesh.bounds = AABB::of(submesh.vertices);
+			submesh.sphere = BoundingSphere::of(submesh.vertices, submesh.bounds);
+			submeshes.push_back(std::move(submesh));
+		}
+		return true;
+	}
+}
+
+bool loadOBJ(const std::filesystem::path& filename, std::vector<SubmeshData>& submeshes, const OBJLoadSettings& settings)
+{
+	std::cout << "Loading model: " << filename.string() << std::endl;
+	auto load_start = std::chrono::steady_clock::now();
+
+	submeshes.clear();
+
+	MappedFile file(filename);
+	if (!file.is_open()) {
+		std::cerr << "Impossible to open the file: " << filename.string() << '\n';
+		return false;
+	}
+
+	// use more threads only for files big enough to pay off
+	unsigned int thread_count = 1;
+	if (settings.parallel) {
+		unsigned int hardware_threads = settings.jobs ? settings.jobs->getThreadCount() + 1 : std::thread::hardware_concurrency();
+		thread_count = settings.thread_count > 0 ? settings.thread_count : std::max(1u, hardware_threads);
+		thread_count = static_cast<unsigned int>(std::clamp<size_t>(file.size() / OBJ_LOADER_MIN_CHUNK_SIZE, 1, thread_count));
+	}
+
+	OBJRecords records;
+	bool parsed = (thread_count > 1) ? parse_obj_parallel(file.view(), records, thread_count, settings.jobs) : parse_obj(file.view(), records);
+	if (!parsed || !build_submeshes(records, settings, submeshes)) {
+		std::cerr << "Parsing failed: " << filename.string() << '\n';
+		submeshes.clear();
+		return false;
+	}
+
+	size_t triangle_count = 0, vertex_count = 0;
+	for (const auto& submesh : submeshes) {
+		triangle_count += submesh.indices.size() / 3;
+		vertex_count += submesh.vertices.size();
+	}
+
+	std::chrono::duration<double, std::milli> load_time = std::chrono::steady_clock::now() - load_start;
+	std::cout << "Model loaded: " << filename.string()
+		<< " (" << submeshes.size() << " submeshes, " << triangle_count << " triangles, " << vertex_count << " vertices, "
+		<< load_time.count() << " ms, " << thread_count << (thread_count > 1 ? " threads)" : " thread)") << std::endl;
+
+	return true;
+}
+
+bool loadOBJ(const std::filesystem::path& filename, std::vector<Vertex>& vertices, std::vector<GLuint>& indices, const OBJLoadSettings& settings)
+{
+	vertices.clear();
+	indices.clear();
+
+	OBJLoadSettings single_mesh_settings = settings;
+	single_mesh_settings.split_groups = false;
+
+	std::vector<SubmeshData> submeshes;
+	if (!loadOBJ(filename, submeshes, single_mesh_settings))
+		return false;
+
+	if (!submeshes.empty()) {
+		vertices = std::move(submeshes.front().vertices);
+		indices = std::move(submeshes.front().indices);
+	}
 	return true;
-}
\ No newline at end of file
+}
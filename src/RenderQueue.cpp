@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <bit>
+#include <tuple>
+
+#include "RenderQueue.hpp"
+
+RenderQueue::~RenderQueue()
+{
+    glDeleteBuffers(1, &draw_data_buffer_);
+    glDeleteBuffers(1, &command_buffer_);
+}
+
+uint64_t RenderQueue::make_key(GLuint program, GLuint vao, GLenum primitive_type, float depth)
+{
+    // 16 bits program, 12 bits vertex array, 4 bits primitive (GL_POINTS..GL_PATCHES), 32 bits depth;
+    // bits of non-negative float compare as unsigned integers
+    uint32_t depth_bits = std::bit_cast<uint32_t>(std::max(depth, 0.0f));
+    return (static_cast<uint64_t>(program & 0xFFFF) << 48) | (static_cast<uint64_t>(vao & 0xFFF) << 36)
+        | (static_cast<uint64_t>(primitive_type & 0xF) << 32) | depth_bits;
+}
+
+void RenderQueue::add(const std::shared_ptr<ShaderProgram>& shader, const Mesh& mesh, std::span<const Mesh::DrawRange> ranges, const DrawData& data, float depth)
+{
+    if (ranges.empty())
+        return;
+
+    if (std::find(shaders_.begin(), shaders_.end(), shader) == shaders_.end())
+        shaders_.push_back(shader);
+
+    Item item{};
+    item.key = make_key(shader->getID(), mesh.getVertexArray(), mesh.getPrimitiveType(), depth);
+    item.shader = shader.get();
+    item.program = shader->getID();
+    item.vao = mesh.getVertexArray();
+    item.primitive_type = mesh.getPrimitiveType();
+    item.index_type = mesh.hasIndices() ? mesh.getIndexType() : 0;
+    item.base_vertex = mesh.getBaseVertex();
+    item.first_index = mesh.getFirstIndex();
+    item.first_range = static_cast<uint32_t>(ranges_.size());
+    item.range_count = static_cast<uint32_t>(ranges.size());
+    item.draw_data = static_cast<uint32_t>(draw_data_.size());
+    items_.push_back(item);
+    ranges_.insert(ranges_.end(), ranges.begin(), ranges.end());
+    draw_data_.push_back(data);
+}
+
+void RenderQueue::submit(RenderStats& stats)
+{
+    if (items_.empty()) {
+        shaders_.clear();
+        return;
+    }
+
+    if (draw_data_buffer_ == 0) {
+        glCreateBuffers(1, &draw_data_buffer_);
+        glCreateBuffers(1, &command_buffer_);
+    }
+
+    // key collisions of truncated IDs are resolved by comparing the full GL names,
+    // equal items stay in order of add(), so the order is the same in every run
+    std::sort(items_.begin(), items_.end(), [](const Item& a, const Item& b) {
+        if (a.key != b.key)
+            return a.key < b.key;
+        return std::tie(a.program, a.vao, a.index_type, a.draw_data) < std::tie(b.program, b.vao, b.index_type, b.draw_data);
+        });
+    auto same_state = [](const Item& a, const Item& b) {
+        return a.program == b.program && a.vao == b.vao && a.primitive_type == b.primitive_type && a.index_type == b.index_type;
+    };
+
+    runs_.clear();
+    commands_.clear();
+    for (size_t i = 0; i < items_.size(); i++) {
+        const auto& item = items_[i];
+        if (i == 0 || !same_state(items_[i - 1], item))
+            runs_.push_back(Run{ i, commands_.size(), 0 });
+
+        for (uint32_t r = item.first_range; r < item.first_range + item.range_count; r++) {
+            const auto& range = ranges_[r];
+            if (item.index_type) {
+                DrawElementsCommand command{ static_cast<GLuint>(range.index_count), 1, item.first_index + range.first_index, item.base_vertex, item.draw_data };
+                commands_.insert(commands_.end(), reinterpret_cast<const char*>(&command), reinterpret_cast<const char*>(&command + 1));
+            }
+            else {
+                DrawArraysCommand command{ static_cast<GLuint>(range.index_count), 1, item.base_vertex + range.first_index, item.draw_data };
+                commands_.insert(commands_.end(), reinterpret_cast<const char*>(&command), reinterpret_cast<const char*>(&command + 1));
+            }
+            runs_.back().count++;
+        }
+    }
+
+    // orphan and refill, buffers are rewritten every frame
+    glNamedBufferData(draw_data_buffer_, static_cast<GLsizeiptr>(draw_data_.size() * sizeof(DrawData)), draw_data_.data(), GL_STREAM_DRAW);
+    glNamedBufferData(command_buffer_, static_cast<GLsizeiptr>(commands_.size()), commands_.data(), GL_STREAM_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MULTIDRAW_DRAW_DATA_BINDING, draw_data_buffer_);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer_);
+
+    // only changed state is set
+    ShaderProgram* current_shader = nullptr;
+    GLuint current_vao = 0;
+    for (const auto& run : runs_) {
+        const auto& item = items_[run.first_item];
+        if (item.shader != current_shader) {
+            item.shader->use();
+            current_shader = item.shader;
+            stats.shader_changes++;
+        }
+        if (item.vao != current_vao) {
+            glBindVertexArray(item.vao);
+            current_vao = item.vao;
+            stats.vertex_array_changes++;
+        }
+
+        auto offset = reinterpret_cast<const void*>(run.offset);
+        if (item.index_type)
+            glMultiDrawElementsIndirect(item.primitive_type, item.index_type, offset, static_cast<GLsizei>(run.count), 0);
+        else
+            glMultiDrawArraysIndirect(item.primitive_type, offset, static_cast<GLsizei>(run.count), 0);
+        stats.draw_calls++;
+        stats.draw_commands += run.count;
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    items_.clear();
+    ranges_.clear();
+    draw_data_.clear();
+    shaders_.clear();
+}
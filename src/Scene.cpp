@@ -0,0 +1,349 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <glm/gtx/euler_angles.hpp>
+
+#include "Scene.hpp"
+
+namespace {
+    float wrap_angle(float angle) { // wrap any float to [0, 360)
+        angle = std::fmod(angle, 360.0f);
+        if (angle < 0.0f)
+            angle += 360.0f;
+        return angle;
+    }
+
+    glm::mat4 create_model_matrix(const glm::vec3& origin, const glm::vec3& eAng, const glm::vec3& scale) {
+        // keep angles in proper range
+        glm::vec3 eA{ wrap_angle(eAng.x), wrap_angle(eAng.y), wrap_angle(eAng.z) };
+
+        glm::mat4 t = glm::translate(glm::mat4(1.0f), origin);
+        glm::mat4 rotm = glm::yawPitchRoll(glm::radians(eA.y), glm::radians(eA.x), glm::radians(eA.z)); //yaw, pitch, roll
+        glm::mat4 s = glm::scale(glm::mat4(1.0f), scale);
+
+        return s * rotm * t;
+    }
+
+    // radius of bounding sphere projected to the screen, relative to half of viewport height
+    float projected_size(const AABB& bounds, const glm::mat4& model_view, const glm::mat4& projection) {
+        if (bounds.empty())
+            return 0.0f;
+        float scale = std::max({ glm::length(glm::vec3(model_view[0])), glm::length(glm::vec3(model_view[1])), glm::length(glm::vec3(model_view[2])) });
+        float radius = glm::length(bounds.extents()) * scale;
+        float distance = glm::length(glm::vec3(model_view * glm::vec4(bounds.center(), 1.0f)));
+        if (distance <= radius)
+            return std::numeric_limits<float>::infinity();
+        return radius * projection[1][1] / distance;
+    }
+
+    // LOD 0 down to MODEL_LOD_SCREEN_SIZE, next LOD at every halving of the size. The LOD changes only
+    // when the size gets MODEL_LOD_HYSTERESIS levels past the threshold, so that it does not pop back and forth.
+    unsigned int select_lod(unsigned int current, unsigned int lod_count, float screen_size) {
+        if (lod_count <= 1)
+            return 0;
+        float level = screen_size > 0.0f ? std::log2(MODEL_LOD_SCREEN_SIZE / screen_size) + 1.0f : static_cast<float>(lod_count);
+        int lowest = static_cast<int>(std::floor(level - MODEL_LOD_HYSTERESIS));
+        int highest = static_cast<int>(std::floor(level + MODEL_LOD_HYSTERESIS));
+        int lod = std::clamp(static_cast<int>(current), lowest, highest);
+        return static_cast<unsigned int>(std::clamp(lod, 0, static_cast<int>(lod_count) - 1));
+    }
+
+    // index of the value in the table, reusing a free entry for a new value
+    template <typename T>
+    uint32_t acquire(const std::shared_ptr<T>& value, std::vector<std::shared_ptr<T>>& table, std::vector<uint32_t>& refs,
+        std::vector<uint32_t>& free_entries, std::unordered_map<const T*, uint32_t>& index) {
+        auto [it, inserted] = index.try_emplace(value.get(), 0);
+        if (inserted) {
+            if (!free_entries.empty()) {
+                it->second = free_entries.back();
+                free_entries.pop_back();
+                table[it->second] = value;
+            }
+            else {
+                it->second = static_cast<uint32_t>(table.size());
+                table.push_back(value);
+                refs.push_back(0);
+            }
+        }
+        refs[it->second]++;
+        return it->second;
+    }
+
+    template <typename T>
+    void release(uint32_t entry, std::vector<std::shared_ptr<T>>& table, std::vector<uint32_t>& refs,
+        std::vector<uint32_t>& free_entries, std::unordered_map<const T*, uint32_t>& index) {
+        if (--refs[entry] > 0)
+            return;
+        index.erase(table[entry].get());
+        table[entry].reset();
+        free_entries.push_back(entry);
+    }
+}
+
+Scene::Id Scene::create(const std::string& name, Id parent)
+{
+    if (!name.empty() && names_.contains(name))
+        throw std::runtime_error("Scene object already exists: " + name);
+
+    uint32_t parent_dense = dense_index(parent);
+
+    uint32_t slot;
+    if (!free_slots_.empty()) {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+    }
+    else {
+        slot = static_cast<uint32_t>(slots_.size());
+        slots_.emplace_back();
+    }
+    uint32_t dense = static_cast<uint32_t>(ids_.size());
+    slots_[slot].dense = dense;
+    Id id{ slot, slots_[slot].generation };
+
+    ids_.push_back(id);
+    parent_.push_back(parent_dense == no_index ? Id{} : parent);
+    children_.emplace_back();
+    if (parent_dense != no_index)
+        children_[parent_dense].push_back(id);
+    transform_.push_back(transforms_.create(parent_dense == no_index ? TransformSystem::none : transform_[parent_dense]));
+    mesh_.push_back(no_index);
+    shader_.push_back(no_index);
+    bounds_.emplace_back();
+    sphere_.emplace_back();
+    world_radius_.push_back(0.0f);
+    cull_index_.push_back(0);
+    lod_.push_back(0);
+    placement_.emplace_back();
+    name_.push_back(name);
+
+    if (!name.empty())
+        names_.emplace(name, id);
+    return id;
+}
+
+Scene::Id Scene::addMesh(Id parent, std::shared_ptr<Mesh> mesh, std::shared_ptr<ShaderProgram> shader,
+    glm::vec3 origin, glm::vec3 eulerAngles, glm::vec3 scale)
+{
+    Id id = create({}, parent);
+    uint32_t dense = dense_index(id);
+
+    mesh_[dense] = acquire(mesh, meshes_, mesh_refs_, free_meshes_, mesh_index_);
+    shader_[dense] = acquire(shader, shaders_, shader_refs_, free_shaders_, shader_index_);
+    bounds_[dense] = mesh->getBounds();
+    sphere_[dense] = mesh->getBoundingSphere();
+    placement_[dense] = Placement{ origin, eulerAngles, scale };
+    update_transform(dense);
+    return id;
+}
+
+void Scene::destroy(Id id)
+{
+    uint32_t dense = dense_index(id);
+    if (dense == no_index)
+        return;
+
+    if (uint32_t parent = dense_index(parent_[dense]); parent != no_index) {
+        auto& siblings = children_[parent];
+        siblings.erase(std::find(siblings.begin(), siblings.end(), id));
+    }
+    destroy_subtree(id);
+}
+
+void Scene::destroy_subtree(Id id)
+{
+    uint32_t dense = dense_index(id);
+
+    // children first, they release their transforms before the parent
+    std::vector<Id> children = std::move(children_[dense]);
+    for (Id child : children)
+        destroy_subtree(child);
+    dense = dense_index(id);
+
+    transforms_.release(transform_[dense]);
+    if (!name_[dense].empty())
+        names_.erase(name_[dense]);
+    if (mesh_[dense] != no_index) {
+        release(mesh_[dense], meshes_, mesh_refs_, free_meshes_, mesh_index_);
+        release(shader_[dense], shaders_, shader_refs_, free_shaders_, shader_index_);
+    }
+
+    // the last object moves to the freed place
+    uint32_t last = static_cast<uint32_t>(ids_.size() - 1);
+    auto remove = [dense](auto& values) {
+        values[dense] = std::move(values.back());
+        values.pop_back();
+    };
+    slots_[ids_[last].slot].dense = dense;
+    remove(ids_);
+    remove(parent_);
+    remove(children_);
+    remove(transform_);
+    remove(mesh_);
+    remove(shader_);
+    remove(bounds_);
+    remove(sphere_);
+    remove(world_radius_);
+    remove(cull_index_);
+    remove(lod_);
+    remove(placement_);
+    remove(name_);
+
+    slots_[id.slot].dense = no_index;
+    slots_[id.slot].generation++;
+    free_slots_.push_back(id.slot);
+}
+
+bool Scene::contains(Id id) const
+{
+    return dense_index(id) != no_index;
+}
+
+uint32_t Scene::dense_index(Id id) const
+{
+    if (id.slot >= slots_.size() || slots_[id.slot].generation != id.generation)
+        return no_index;
+    return slots_[id.slot].dense;
+}
+
+Scene::Id Scene::find(const std::string& name) const
+{
+    auto it = names_.find(name);
+    return it == names_.end() ? Id{} : it->second;
+}
+
+void Scene::update_transform(uint32_t dense)
+{
+    const auto& placement = placement_[dense];
+    transforms_.setLocal(transform_[dense], create_model_matrix(placement.position, placement.eulerAngles, placement.scale));
+}
+
+void Scene::setPosition(Id id, const glm::vec3& position)
+{
+    if (uint32_t dense = dense_index(id); dense != no_index) {
+        placement_[dense].position = position;
+        update_transform(dense);
+    }
+}
+
+void Scene::setEulerAngles(Id id, const glm::vec3& eulerAngles)
+{
+    if (uint32_t dense = dense_index(id); dense != no_index) {
+        placement_[dense].eulerAngles = eulerAngles;
+        update_transform(dense);
+    }
+}
+
+void Scene::setScale(Id id, const glm::vec3& scale)
+{
+    if (uint32_t dense = dense_index(id); dense != no_index) {
+        placement_[dense].scale = scale;
+        update_transform(dense);
+    }
+}
+
+void Scene::setModelMatrix(Id id, const glm::mat4& model_matrix)
+{
+    if (uint32_t dense = dense_index(id); dense != no_index)
+        transforms_.setLocal(transform_[dense], model_matrix);
+}
+
+void Scene::translate(Id id, const glm::vec3& offset)
+{
+    if (uint32_t dense = dense_index(id); dense != no_index) {
+        placement_[dense].position += offset;
+        update_transform(dense);
+    }
+}
+
+void Scene::rotate(Id id, const glm::vec3& pitch_yaw_roll_offs)
+{
+    if (uint32_t dense = dense_index(id); dense != no_index) {
+        placement_[dense].eulerAngles += pitch_yaw_roll_offs;
+        update_transform(dense);
+    }
+}
+
+void Scene::scale(Id id, const glm::vec3& scale_offs)
+{
+    if (uint32_t dense = dense_index(id); dense != no_index) {
+        placement_[dense].scale *= scale_offs;
+        update_transform(dense);
+    }
+}
+
+unsigned int Scene::getLod(Id id) const
+{
+    uint32_t dense = dense_index(id);
+    if (dense == no_index)
+        return 0;
+    unsigned int lod = lod_[dense];
+    for (Id child : children_[dense])
+        lod = std::max(lod, getLod(child));
+    return lod;
+}
+
+void Scene::update(RenderStats& stats)
+{
+    transforms_.update();
+    stats.transforms_updated = transforms_.getUpdatedCount();
+}
+
+void Scene::cull(FrustumCuller& culler, JobSystem& jobs)
+{
+    // culler slots of meshes in dense order
+    uint32_t count = static_cast<uint32_t>(culler.size());
+    for (uint32_t i = 0; i < mesh_.size(); i++)
+        if (mesh_[i] != no_index)
+            cull_index_[i] = count++;
+    culler.resize(count);
+
+    jobs.parallelFor(mesh_.size(), JOB_GRAIN_SIZE, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            if (mesh_[i] == no_index)
+                continue;
+            const glm::mat4& model_matrix = transforms_.getWorld(transform_[i]);
+            const auto& sphere = sphere_[i];
+            float scale = std::max({ glm::length(glm::vec3(model_matrix[0])), glm::length(glm::vec3(model_matrix[1])), glm::length(glm::vec3(model_matrix[2])) });
+            glm::vec3 center = glm::vec3(model_matrix * glm::vec4(sphere.center, 1.0f));
+            world_radius_[i] = sphere.empty() ? 0.0f : sphere.radius * scale;
+            culler.set(cull_index_[i], center, world_radius_[i]);
+        }
+        });
+}
+
+void Scene::draw(const glm::mat4& view_matrix, const glm::mat4& projection_matrix, const FrustumCuller& culler,
+    RenderQueue& queue, RenderStats& stats, bool lod_debug)
+{
+    static const glm::vec4 lod_colors[] = {
+        { 0.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 0.0f, 1.0f }, { 1.0f, 0.5f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 1.0f, 1.0f }
+    };
+
+    for (uint32_t i = 0; i < mesh_.size(); i++) {
+        if (mesh_[i] == no_index || !culler.isVisible(cull_index_[i]))
+            continue;
+
+        const Mesh& mesh = *meshes_[mesh_[i]];
+        const glm::mat4& model_matrix = transforms_.getWorld(transform_[i]);
+        glm::mat4 model_view = view_matrix * model_matrix;
+
+        float screen_size = projected_size(bounds_[i], model_view, projection_matrix);
+        lod_[i] = select_lod(lod_[i], mesh.getLodCount(), screen_size);
+
+        ranges_.clear();
+        if (lod_[i] == 0 && mesh.hasMeshlets()) {
+            glm::vec3 camera_position = glm::vec3(glm::inverse(model_view)[3]);
+            mesh.selectRanges(Frustum(projection_matrix * model_view), camera_position, stats, ranges_);
+        }
+        else {
+            mesh.selectRanges(lod_[i], stats, ranges_);
+        }
+
+        RenderQueue::DrawData data{ model_matrix * mesh.getDecodeMatrix() };
+        if (lod_debug)
+            data.tint = lod_colors[std::min<size_t>(lod_[i], std::size(lod_colors) - 1)];
+
+        // distance of the nearest point of the bounding sphere, for front to back order
+        float depth = -(model_view * glm::vec4(sphere_[i].center, 1.0f)).z - world_radius_[i];
+        queue.add(shaders_[shader_[i]], mesh, ranges_, data, depth);
+    }
+}
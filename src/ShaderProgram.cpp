@@ -1,49 +1,287 @@
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <fstream>
+#include <iomanip>
 #include <sstream>
 
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 
 #include "ShaderProgram.hpp"
+#include "Config.hpp"
+#include "Hash.hpp"
 #include "Mesh.hpp" 
 
+namespace {
+    // file "<key>.progbin" in SHADER_CACHE_DIRECTORY: header followed by the binary
+    struct ProgramBinaryHeader {
+        char magic[4];      // "ICPS"
+        uint32_t version;
+        uint64_t key;
+        uint32_t format;    // from glGetProgramBinary()
+        uint32_t length;
+    };
+    constexpr uint32_t program_binary_version = 1;
+
+    // binding points from Config.hpp, defined right after #version of every stage
+    // so that the shaders can not drift from the C++ side
+    std::string add_config_defines(std::string source) {
+        static const std::string defines =
+            "#define FRAME_UNIFORMS_BINDING " + std::to_string(FRAME_UNIFORMS_BINDING) + "\n"
+            "#define MULTIDRAW_DRAW_DATA_BINDING " + std::to_string(MULTIDRAW_DRAW_DATA_BINDING) + "\n"
+            "#define INSTANCE_DATA_BINDING " + std::to_string(INSTANCE_DATA_BINDING) + "\n";
+
+        size_t version = source.find("#version");
+        if (version == std::string::npos)
+            return defines + source;
+        size_t end = source.find('\n', version);
+        if (end == std::string::npos) {
+            source += '\n';
+            end = source.size() - 1;
+        }
+        // keep line numbers of compiler messages
+        size_t line = std::count(source.begin(), source.begin() + end, '\n') + 2;
+        source.insert(end + 1, defines + "#line " + std::to_string(line) + "\n");
+        return source;
+    }
 
+    std::filesystem::path program_binary_path(uint64_t key) {
+        std::ostringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << key << ".progbin";
+        return std::filesystem::path(SHADER_CACHE_DIRECTORY) / name.str();
+    }
+}
 
 ShaderProgram::ShaderProgram(const std::string& vertex_shader_code, const std::string& fragment_shader_code) {
-    // compile shaders and store IDs for linker
-    auto vertex_shader = compile_shader(vertex_shader_code, GL_VERTEX_SHADER);
-    auto fragment_shader = compile_shader(fragment_shader_code, GL_FRAGMENT_SHADER);
+    // only started, see finish_pending()
+    pending_ = start({ { GL_VERTEX_SHADER, vertex_shader_code }, { GL_FRAGMENT_SHADER, fragment_shader_code } });
+}
+
+ShaderProgram::ShaderProgram(const std::filesystem::path& VS_file, const std::filesystem::path& FS_file) :
+    ShaderProgram{ std::vector<SourceFile>{ { GL_VERTEX_SHADER, VS_file }, { GL_FRAGMENT_SHADER, FS_file } } } {
+}
 
-    std::vector<GLuint> shader_ids{ vertex_shader, fragment_shader };
+ShaderProgram::ShaderProgram(const std::filesystem::path& CS_file) :
+    ShaderProgram{ std::vector<SourceFile>{ { GL_COMPUTE_SHADER, CS_file } } } {
+}
 
-    // link all compiled shaders into shader program 
-    ID = link_shader(shader_ids);
-    std::cout << "Linked shader ID: " << ID << std::endl;
+ShaderProgram::ShaderProgram(std::vector<SourceFile> files) :
+    files_{ std::move(files) } {
+    for (auto& file : files_) {
+        std::error_code ec;
+        file.time = std::filesystem::last_write_time(file.path, ec);
+    }
+    pending_ = start(read_stages());
 }
 
-ShaderProgram::ShaderProgram(const std::filesystem::path& VS_file, const std::filesystem::path& FS_file) :
-    ShaderProgram{ read_text_file(VS_file), read_text_file(FS_file) } {
+std::vector<ShaderProgram::Stage> ShaderProgram::read_stages(void) {
+    std::vector<Stage> stages;
+    for (const auto& file : files_)
+        stages.push_back(Stage{ file.type, read_text_file(file.path) });
+    return stages;
 }
 
-// Get location or write error to console
-GLuint ShaderProgram::getUniformLocation(const std::string& name) {
-    // deferred (lazy) cache generation
+std::string ShaderProgram::file_names(void) const {
+    std::string names;
+    for (const auto& file : files_)
+        names += (names.empty() ? "" : ", ") + file.path.string();
+    return names;
+}
 
-    // Check if the location is already cached
-    if (uniform_location_cache.contains(name)) { //C++20
-        return uniform_location_cache[name];
+ShaderProgram::~ShaderProgram(void) {  //deallocate shader program
+    for (auto* pending : { &pending_, &reload_ }) {
+        if (!*pending)
+            continue;
+        for (auto shader : (*pending)->shaders)
+            glDeleteShader(shader);
+        glDeleteProgram((*pending)->program);
     }
+    deactivate();
+    glDeleteProgram(ID);
+    ID = 0;
+}
 
-    // Get the location and cache it
-    auto loc = glGetUniformLocation(ID, name.c_str());
-    if (loc == -1) {
-        std::cerr << "No uniform with name: " << name << '\n';
+// Starts compilation and linking (or loads cached binary) without checking any status.
+ShaderProgram::Pending ShaderProgram::start(std::vector<Stage> stages) {
+    for (auto& stage : stages)
+        stage.source_code = add_config_defines(std::move(stage.source_code));
+
+    Pending pending;
+    pending.start = std::chrono::steady_clock::now();
+    pending.cache_key = program_cache_key(stages);
+    pending.program = load_program_binary(pending.cache_key);
+    pending.from_cache = pending.program != 0;
+    if (!pending.from_cache) {
+        // compile shaders and store IDs for linker
+        for (const auto& stage : stages)
+            pending.shaders.push_back(compile_shader(stage.source_code, stage.type));
+
+        // link all compiled shaders into shader program 
+        pending.program = link_shader(pending.shaders);
+    }
+    return pending;
+}
+
+bool ShaderProgram::is_complete(GLuint program) {
+    // without the extension, status query just waits
+    if (!GLEW_KHR_parallel_shader_compile && !GLEW_ARB_parallel_shader_compile)
+        return true;
+    GLint complete = GL_FALSE;
+    glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
+
+bool ShaderProgram::isReady(void) const {
+    return !pending_ || is_complete(pending_->program);
+}
+
+// Checks compile and link status (waits for the driver if needed), prints logs.
+bool ShaderProgram::finish(Pending& pending) {
+    bool ok = true;
+    for (auto shader : pending.shaders) {
+        GLint status;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+        if (status == GL_FALSE) {
+            std::cerr << getShaderInfoLog(shader) << std::endl;
+            ok = false;
+        }
     }
-    else {
-        uniform_location_cache[name] = loc;
+
+    GLint status = GL_FALSE;
+    glGetProgramiv(pending.program, GL_LINK_STATUS, &status);
+    if (ok && status == GL_FALSE) {
+        std::cerr << "Error linking shader program." << std::endl;
+        std::cerr << getProgramInfoLog(pending.program) << std::endl;
+        ok = false;
+    }
+
+    for (auto shader : pending.shaders) {
+        glDetachShader(pending.program, shader);
+        glDeleteShader(shader);
+    }
+    pending.shaders.clear();
+
+    if (!ok) {
+        glDeleteProgram(pending.program);
+        pending.program = 0;
+        return false;
+    }
+
+    // print out linking log
+    if (!pending.from_cache) {
+        std::string progLog = getProgramInfoLog(pending.program);
+        if (!progLog.empty()) std::cout << "Shader Program Log:\n" << progLog << std::endl;
+        save_program_binary(pending.program, pending.cache_key);
+    }
+
+    // from start, i.e. including time when other programs were compiled in parallel
+    std::chrono::duration<double, std::milli> link_time = std::chrono::steady_clock::now() - pending.start;
+    std::cout << "Linked shader ID: " << pending.program << (pending.from_cache ? " (binary cache)" : " (compiled)") << " in " << link_time.count() << " ms" << std::endl;
+    return true;
+}
+
+void ShaderProgram::finish_pending(void) {
+    Pending pending = std::move(*pending_);
+    pending_.reset();
+    if (!finish(pending))
+        throw std::runtime_error("Shader compilation or linking failed.");
+    ID = pending.program;
+    cache_uniform_locations();
+}
+
+bool ShaderProgram::hotReload(void) {
+    if (files_.empty() || pending_)
+        return false;
+
+    if (reload_) {
+        if (!is_complete(reload_->program))
+            return false;
+        Pending reload = std::move(*reload_);
+        reload_.reset();
+        if (!finish(reload)) {
+            std::cerr << "Shader reload failed, keeping the previous program: " << file_names() << '\n';
+            return false;
+        }
+
+        if (currently_used_ID == ID)
+            currently_used_ID = 0; // next use() binds the new program
+        glDeleteProgram(ID);
+        ID = reload.program;
+        cache_uniform_locations();
+        std::cout << "Shader reloaded: " << file_names() << '\n';
+        return true;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double>(now - last_reload_check_).count() < SHADER_HOT_RELOAD_INTERVAL)
+        return false;
+    last_reload_check_ = now;
+
+    bool changed = false;
+    for (auto& file : files_) {
+        std::error_code ec;
+        auto time = std::filesystem::last_write_time(file.path, ec);
+        if (ec)
+            return false;
+        if (time != file.time) {
+            file.time = time;
+            changed = true;
+        }
+    }
+    if (!changed)
+        return false;
+
+    try {
+        reload_ = start(read_stages());
+    }
+    catch (std::exception const& e) {
+        std::cerr << "Shader reload failed: " << e.what() << '\n';
+    }
+    return false;
+}
+
+// Slot with location or -1, writes error to console (once per name)
+GLint* ShaderProgram::uniform_slot(std::string_view name) {
+    if (pending_)
+        finish_pending();
+
+    // single lookup, cache is filled after linking
+    auto it = uniform_location_cache.find(name);
+    if (it != uniform_location_cache.end())
+        return &it->second;
+
+    // not active in the program, remember it as absent
+    std::cerr << "No uniform with name: " << name << '\n';
+    return &uniform_location_cache.emplace(std::string(name), -1).first->second;
+}
+
+// Locations of all active uniforms of the linked program, arrays are found also without "[0]".
+// Names known from a previous program keep their slots (absent ones get -1).
+void ShaderProgram::cache_uniform_locations(void) {
+    for (auto& [name, location] : uniform_location_cache)
+        location = -1;
+
+    GLint count = 0;
+    glGetProgramInterfaceiv(ID, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+    GLint max_length = 0;
+    glGetProgramInterfaceiv(ID, GL_UNIFORM, GL_MAX_NAME_LENGTH, &max_length);
+
+    std::vector<char> name(std::max(max_length, 1));
+    for (GLint i = 0; i < count; i++) {
+        const GLenum property = GL_LOCATION;
+        GLint location = -1;
+        glGetProgramResourceiv(ID, GL_UNIFORM, i, 1, &property, 1, nullptr, &location);
+        if (location == -1)
+            continue; // member of uniform block
+        GLsizei length = 0;
+        glGetProgramResourceName(ID, GL_UNIFORM, i, static_cast<GLsizei>(name.size()), &length, name.data());
+        std::string uniform_name(name.data(), length);
+        if (uniform_name.ends_with("[0]"))
+            uniform_location_cache.insert_or_assign(uniform_name.substr(0, uniform_name.size() - 3), location);
+        uniform_location_cache.insert_or_assign(std::move(uniform_name), location);
     }
-    return loc;
 }
 
 GLint ShaderProgram::getAttribLocation(const std::string& name) {
@@ -135,61 +373,131 @@ GLuint ShaderProgram::compile_shader(const std::string & source_code, const GLen
 
     glShaderSource(shader_ID, 1, &src_cstr, nullptr);
     glCompileShader(shader_ID);
-    {
-        GLint status;
-        glGetShaderiv(shader_ID, GL_COMPILE_STATUS, &status);
-        if (status == GL_FALSE) {
-            std::cerr << getShaderInfoLog(shader_ID) << std::endl;
-            glDeleteShader(shader_ID);
-            throw std::runtime_error("Shader compilation failed.");
-        }
-    }
 
+    // status is checked by finish(), querying it now would wait for the compiler
     return shader_ID;
 }
 
-GLuint ShaderProgram::link_shader(const std::vector<GLuint> shader_ids) {
+GLuint ShaderProgram::link_shader(const std::vector<GLuint>& shader_ids) {
     GLuint prog_ID = glCreateProgram();
 
     for (const auto& id : shader_ids)
         glAttachShader(prog_ID, id);
 
+    // allow glGetProgramBinary() for the cache
+    glProgramParameteri(prog_ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
     // force OpenGL to use specific slots(locations) for certain vertex attributes,
     // must be set before linking
     glBindAttribLocation(prog_ID, Mesh::attribute_location_position, "aPos");
     glBindAttribLocation(prog_ID, Mesh::attribute_location_normal, "aColor");
 
+    // shaders are detached and result checked by finish()
     glLinkProgram(prog_ID);
+    return prog_ID;
+}
 
-    for (const auto& id : shader_ids) {
-        glDetachShader(prog_ID, id);
-        glDeleteShader(id);
+std::string ShaderProgram::read_text_file(const std::filesystem::path & filepath) {
+    std::ifstream file(filepath);
+    if (!file.is_open())
+        throw std::runtime_error(std::string("Error opening file: ") + filepath.string());
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+// Sources and driver identification, a binary is valid only for the same driver.
+uint64_t ShaderProgram::program_cache_key(const std::vector<Stage>& stages) {
+    uint64_t key = fnv1a("");
+    for (const auto& stage : stages) {
+        key = fnv1a(stage.source_code, key);
+        key = fnv1a(std::string_view("\0", 1), key); // separator, "ab"+"c" != "a"+"bc"
+    }
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+        auto value = reinterpret_cast<const char*>(glGetString(name));
+        key = fnv1a(value ? value : "", key);
     }
+    return key;
+}
 
-    // check link result, print info & throw error (if any)
-    {
-        GLint status;
+// Returns 0 when there is no usable binary, drivers may reject binaries e.g. after update.
+GLuint ShaderProgram::load_program_binary(uint64_t key) {
+    if (!SHADER_CACHE_ENABLED)
+        return 0;
+    GLint format_count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+    if (format_count == 0)
+        return 0;
+
+    auto path = program_binary_path(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        return 0;
+
+    ProgramBinaryHeader header;
+    std::vector<char> binary;
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(header))
+        && std::memcmp(header.magic, "ICPS", 4) == 0 && header.version == program_binary_version && header.key == key) {
+        binary.resize(header.length);
+        if (!file.read(binary.data(), binary.size()))
+            binary.clear();
+    }
+    file.close();
+
+    GLuint prog_ID = 0;
+    if (!binary.empty()) {
+        prog_ID = glCreateProgram();
+        glProgramBinary(prog_ID, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+        GLint status = GL_FALSE;
         glGetProgramiv(prog_ID, GL_LINK_STATUS, &status);
         if (status == GL_FALSE) {
-            std::cerr << "Error linking shader program." << std::endl;
-            std::cerr << getProgramInfoLog(prog_ID) << std::endl;
             glDeleteProgram(prog_ID);
-            throw std::runtime_error("Shader linking failed.");
+            prog_ID = 0;
         }
     }
 
-    // print out linking log
-    std::string progLog = getProgramInfoLog(prog_ID);
-    if (!progLog.empty()) std::cout << "Shader Program Log:\n" << progLog << std::endl;
-    
+    if (prog_ID == 0) {
+        std::cerr << "Program binary rejected, compiling from source: " << path.string() << '\n';
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
     return prog_ID;
 }
 
-std::string ShaderProgram::read_text_file(const std::filesystem::path & filepath) {
-    std::ifstream file(filepath);
-    if (!file.is_open())
-        throw std::runtime_error(std::string("Error opening file: ") + filepath.string());
-    std::stringstream ss;
-    ss << file.rdbuf();
-    return ss.str();
-}
\ No newline at end of file
+void ShaderProgram::save_program_binary(GLuint program, uint64_t key) {
+    if (!SHADER_CACHE_ENABLED)
+        return;
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    ProgramBinaryHeader header{};
+    std::memcpy(header.magic, "ICPS", 4);
+    header.version = program_binary_version;
+    header.key = key;
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, nullptr, &format, binary.data());
+    header.format = format;
+    header.length = static_cast<uint32_t>(binary.size());
+
+    // write to temporary file and rename, so that interrupted write never leaves valid-looking binary
+    auto path = program_binary_path(key);
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    auto temp_path = path;
+    temp_path += ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Program binary can not be written: " << path.string() << '\n';
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), binary.size());
+        if (!file.good())
+            return;
+    }
+    std::filesystem::rename(temp_path, path, ec);
+}
@@ -1,33 +1,26 @@
 #include "TrackerThread.hpp"
 
-void tracker_thread_func(cv::VideoCapture& capture,
-    std::atomic<bool>& tracker_terminate,
+bool tracker_step(cv::VideoCapture& capture,
+    cv::CascadeClassifier& face_cascade,
     std::atomic<bool>& tracker_buffer_empty,
     synced_deque<cv::Mat>& frames_deque,
     synced_deque<std::vector<cv::Point2f>>& points_deque) {
 
-    cv::CascadeClassifier face_cascade;
-    face_cascade = cv::CascadeClassifier("../resources/haarcascade_frontalface_default.xml");
-
-
     cv::Mat frame;
-    while (!tracker_terminate)
+    if (!capture.read(frame))
     {
+        tracker_buffer_empty = true;
+        return false;
+    }
 
-        if (!capture.read(frame))
-        {
-            tracker_buffer_empty = true;
-            break;
-        }
-
-        std::vector<cv::Point2f> faces = find_face(frame, face_cascade);
+    std::vector<cv::Point2f> faces = find_face(frame, face_cascade);
 
-        points_deque.push_back(faces);
-        frames_deque.push_back(frame.clone());
+    points_deque.push_back(faces);
+    frames_deque.push_back(frame.clone());
 
-        points_deque.notify();
-        frames_deque.notify();
-    }
+    points_deque.notify();
+    frames_deque.notify();
+    return true;
 }
 
 std::vector<cv::Point2f> find_face(cv::Mat& frame, cv::CascadeClassifier& face_cascade)
@@ -0,0 +1,94 @@
+#include <algorithm>
+
+#include "TransformSystem.hpp"
+
+TransformSystem::Handle TransformSystem::create(Handle parent)
+{
+    Handle node;
+    if (!free_.empty()) {
+        node = free_.back();
+        free_.pop_back();
+        local_[node] = glm::mat4(1.0f);
+        parent_[node] = parent;
+        order_valid_ = false; // reused slot may precede its parent
+    }
+    else {
+        node = static_cast<Handle>(local_.size());
+        local_.emplace_back(1.0f);
+        world_.emplace_back(1.0f);
+        parent_.push_back(parent);
+        dirty_.push_back(0);
+        changed_.push_back(0);
+        if (order_valid_)
+            order_.push_back(node); // parent already exists, so it is earlier in the order
+    }
+    dirty_[node] = 1;
+    any_dirty_ = true;
+    return node;
+}
+
+void TransformSystem::release(Handle node)
+{
+    parent_[node] = none;
+    dirty_[node] = 0;
+    free_.push_back(node);
+    order_valid_ = false;
+}
+
+void TransformSystem::setParent(Handle node, Handle parent)
+{
+    parent_[node] = parent;
+    dirty_[node] = 1;
+    any_dirty_ = true;
+    order_valid_ = false;
+}
+
+void TransformSystem::setLocal(Handle node, const glm::mat4& local)
+{
+    local_[node] = local;
+    dirty_[node] = 1;
+    any_dirty_ = true;
+}
+
+// alive nodes sorted by depth, only after hierarchy changes
+void TransformSystem::rebuild_order()
+{
+    std::vector<uint8_t> released(local_.size(), 0);
+    for (Handle node : free_)
+        released[node] = 1;
+
+    std::vector<uint32_t> depth(local_.size(), 0);
+    order_.clear();
+    for (Handle node = 0; node < local_.size(); node++) {
+        if (released[node])
+            continue;
+        for (Handle p = parent_[node]; p != none; p = parent_[p])
+            depth[node]++;
+        order_.push_back(node);
+    }
+    std::stable_sort(order_.begin(), order_.end(), [&](Handle a, Handle b) { return depth[a] < depth[b]; });
+    order_valid_ = true;
+}
+
+void TransformSystem::update()
+{
+    updated_count_ = 0;
+    if (!any_dirty_)
+        return;
+    if (!order_valid_)
+        rebuild_order();
+
+    // a node is recomputed when it changed itself or its parent was recomputed
+    std::fill(changed_.begin(), changed_.end(), 0);
+    for (Handle node : order_) {
+        Handle parent = parent_[node];
+        bool parent_changed = parent != none && changed_[parent];
+        if (!dirty_[node] && !parent_changed)
+            continue;
+        world_[node] = parent == none ? local_[node] : world_[parent] * local_[node];
+        dirty_[node] = 0;
+        changed_[node] = 1;
+        updated_count_++;
+    }
+    any_dirty_ = false;
+}